@@ -58,6 +58,8 @@ public class MicrosoftOpenXR : ModuleRules
 		PublicDependencyModuleNames.AddRange(
 			new string[]
 			{
+				"AugmentedReality",
+				"RenderCore",
 				"NuGetModule"
 			}
 		);
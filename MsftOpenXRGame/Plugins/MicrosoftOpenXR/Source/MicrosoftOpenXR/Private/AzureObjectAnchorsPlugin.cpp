@@ -227,8 +227,11 @@ namespace MicrosoftOpenXR
 					FOpenXRMeshUpdate* MeshUpdate = TrackedMeshHolder->AllocateMeshUpdate(data.Key);
 					MeshUpdate->Type = EARObjectClassification::SceneObject;
 
-					MeshUpdate->Indices = data.Value.Indices;
-					MeshUpdate->Vertices = data.Value.Vertices;
+					if (data.Value.RenderData.IsValid())
+					{
+						MeshUpdate->Indices = data.Value.RenderData->GetIndices();
+						MeshUpdate->Vertices = data.Value.RenderData->GetVertices();
+					}
 
 					XrSpaceLocation Location{ XR_TYPE_SPACE_LOCATION };
 					xrLocateSpace(data.Value.Space, TrackingSpace, DisplayTime, &Location);
@@ -596,7 +599,7 @@ namespace MicrosoftOpenXR
 		TArray<UARMeshGeometry*> Meshes = UARBlueprintLibrary::GetAllGeometriesByClass<UARMeshGeometry>();
 		for (auto& data : AOAMap)
 		{
-			if (data.Value.CollisionInfo == nullptr)
+			if (!data.Value.CollisionInfo.IsValid())
 			{
 				continue;
 			}
@@ -744,7 +747,8 @@ namespace MicrosoftOpenXR
 										Vertices[i] = MicrosoftOpenXR::WMRUtility::FromFloat3(SrcVertices[i], Self->WorldToMetersScale);
 									}
 
-									Context.CollisionInfo = new TrackedGeometryCollision(Vertices, Indices);
+									const FTrackedMeshDataRef ModelData = MakeTrackedMeshData(MoveTemp(Vertices), MoveTemp(Indices));
+									Context.CollisionInfo = MakeShared<TrackedGeometryCollision>(ModelData);
 
 									// Update the MRMesh data with the chosen render mode.
 									Self->TrackedMeshHolder->StartMeshUpdates();
@@ -753,8 +757,7 @@ namespace MicrosoftOpenXR
 									if (Self->AzureObjectAnchorConfiguration.ObjectRenderMode == EObjectRenderMode::Mesh)
 									{
 										// Use the full mesh data in the MRMesh
-										Context.Indices = Indices;
-										Context.Vertices = Vertices;
+										Context.RenderData = ModelData;
 									}
 									else if (Self->AzureObjectAnchorConfiguration.ObjectRenderMode == EObjectRenderMode::BoundingBox)
 									{
@@ -764,11 +767,17 @@ namespace MicrosoftOpenXR
 										FVector Center = WMRUtility::FromFloat3(Model.BoundingBox().Center, Self->WorldToMetersScale);
 										FVector HalfExtents = WMRUtility::FromFloat3(Model.BoundingBox().Extents / 2.0f, Self->WorldToMetersScale);
 
-										TrackedGeometryCollision::CreateMeshDataForBoundingBox(Center, HalfExtents, Context.Vertices, Context.Indices);
+										TArray<FVector> BoxVertices;
+										TArray<MRMESH_INDEX_TYPE> BoxIndices;
+										TrackedGeometryCollision::CreateMeshDataForBoundingBox(Center, HalfExtents, BoxVertices, BoxIndices);
+										Context.RenderData = MakeTrackedMeshData(MoveTemp(BoxVertices), MoveTemp(BoxIndices));
 									}
 
-									MeshUpdate->Indices = Context.Indices;
-									MeshUpdate->Vertices = Context.Vertices;
+									if (Context.RenderData.IsValid())
+									{
+										MeshUpdate->Indices = Context.RenderData->GetIndices();
+										MeshUpdate->Vertices = Context.RenderData->GetVertices();
+									}
 
 									MeshUpdate->Type = EARObjectClassification::SceneObject;
 									MeshUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
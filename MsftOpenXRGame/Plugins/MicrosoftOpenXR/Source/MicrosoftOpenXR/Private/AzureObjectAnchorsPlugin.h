@@ -97,10 +97,10 @@ namespace MicrosoftOpenXR
 			bool HasChanged = false;
 			OA::ObjectInstanceState LastKnownState;
 
-			TArray<struct FVector> Vertices;
-			TArray<MRMESH_INDEX_TYPE> Indices;
+			// Mesh shown for the object, shares the model data with CollisionInfo when the full mesh is rendered.
+			FTrackedMeshDataPtr RenderData;
 
-			TrackedGeometryCollision* CollisionInfo = nullptr;
+			TSharedPtr<TrackedGeometryCollision> CollisionInfo;
 
 		public:
 			void ResetObjectInstance(IOpenXRARTrackedMeshHolder* TrackedMeshHolder)
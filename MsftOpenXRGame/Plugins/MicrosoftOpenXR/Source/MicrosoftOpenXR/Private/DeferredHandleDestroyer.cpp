@@ -0,0 +1,113 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "DeferredHandleDestroyer.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+DEFINE_STAT(STAT_DestroyScene);
+DEFINE_STAT(STAT_DestroySceneObserver);
+
+namespace MicrosoftOpenXR
+{
+	static TUniquePtr<FDeferredHandleDestroyer> GDeferredHandleDestroyer;
+
+	void FDeferredHandleDestroyer::Startup()
+	{
+		GDeferredHandleDestroyer.Reset(new FDeferredHandleDestroyer());
+	}
+
+	void FDeferredHandleDestroyer::Shutdown()
+	{
+		GDeferredHandleDestroyer.Reset();
+	}
+
+	FDeferredHandleDestroyer& FDeferredHandleDestroyer::Get()
+	{
+		check(GDeferredHandleDestroyer.IsValid());
+		return *GDeferredHandleDestroyer;
+	}
+
+	FDeferredHandleDestroyer::FDeferredHandleDestroyer()
+	{
+		if (FPlatformProcess::SupportsMultithreading())
+		{
+			WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+			Thread = FRunnableThread::Create(this, TEXT("MicrosoftOpenXRHandleDestroyer"), 0, TPri_Lowest);
+		}
+	}
+
+	FDeferredHandleDestroyer::~FDeferredHandleDestroyer()
+	{
+		if (Thread != nullptr)
+		{
+			// Kill calls Stop and waits for the thread to destroy what it has already taken.
+			Thread->Kill(true);
+			delete Thread;
+			Thread = nullptr;
+		}
+		DestroyPending();
+
+		if (WakeEvent != nullptr)
+		{
+			FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+			WakeEvent = nullptr;
+		}
+	}
+
+	uint32 FDeferredHandleDestroyer::Run()
+	{
+		while (!bStopping)
+		{
+			WakeEvent->Wait();
+			DestroyPending();
+		}
+		return 0;
+	}
+
+	void FDeferredHandleDestroyer::Stop()
+	{
+		bStopping = true;
+		WakeEvent->Trigger();
+	}
+
+	void FDeferredHandleDestroyer::Flush()
+	{
+		// DestroyLock is held while the thread destroys a batch, so everything queued before this call is destroyed on return.
+		DestroyPending();
+	}
+
+	void FDeferredHandleDestroyer::Enqueue(TUniqueFunction<void()>&& DestroyFunction, TStatId StatId)
+	{
+		{
+			FScopeLock Lock(&PendingLock);
+			Pending.Add({MoveTemp(DestroyFunction), StatId});
+		}
+
+		if (Thread != nullptr)
+		{
+			WakeEvent->Trigger();
+		}
+		else
+		{
+			DestroyPending();
+		}
+	}
+
+	void FDeferredHandleDestroyer::DestroyPending()
+	{
+		FScopeLock DestroyScope(&DestroyLock);
+		{
+			FScopeLock Lock(&PendingLock);
+			Swap(Pending, Batch);
+		}
+		for (FPendingDestroy& Entry : Batch)
+		{
+			FScopeCycleCounter Counter(Entry.StatId);
+			Entry.DestroyFunction();
+		}
+		Batch.Reset();
+	}
+}	 // namespace MicrosoftOpenXR
@@ -0,0 +1,75 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "OpenXRCommon.h"
+#include "Stats/Stats.h"
+#include "UniqueHandle.h"
+
+DECLARE_STATS_GROUP(TEXT("MicrosoftOpenXR"), STATGROUP_MicrosoftOpenXR, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Destroy Scene"), STAT_DestroyScene, STATGROUP_MicrosoftOpenXR, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Destroy Scene Observer"), STAT_DestroySceneObserver, STATGROUP_MicrosoftOpenXR, );
+
+class FEvent;
+class FRunnableThread;
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Destroys OpenXR handles on a low priority thread, for handles that are slow to destroy, like scenes.
+	/// Handles are destroyed in batches in the order they were queued, so a parent queued after its children is destroyed last.
+	/// The time spent destroying each type of handle is reported under the MicrosoftOpenXR stat group.
+	/// Queued handles must be flushed before the session that owns them is destroyed.
+	/// </summary>
+	class FDeferredHandleDestroyer : public FRunnable
+	{
+	public:
+		static void Startup();
+		// Destroys every queued handle and stops the thread.
+		static void Shutdown();
+		static FDeferredHandleDestroyer& Get();
+
+		~FDeferredHandleDestroyer();
+
+		template <typename HandleType>
+		void Destroy(TUniqueExtHandle<HandleType>&& Handle, TStatId StatId)
+		{
+			if (Handle)
+			{
+				Enqueue([Handle = MoveTemp(Handle)]() mutable { Handle.Reset(); }, StatId);
+			}
+		}
+
+		// Destroys every queued handle on the calling thread, waiting for a batch the thread is already destroying.
+		void Flush();
+
+		// FRunnable
+		uint32 Run() override;
+		void Stop() override;
+
+	private:
+		FDeferredHandleDestroyer();
+
+		void Enqueue(TUniqueFunction<void()>&& DestroyFunction, TStatId StatId);
+		void DestroyPending();
+
+		struct FPendingDestroy
+		{
+			TUniqueFunction<void()> DestroyFunction;
+			TStatId StatId;
+		};
+
+		FCriticalSection PendingLock;
+		TArray<FPendingDestroy> Pending;
+		// Held while a batch is destroyed, so batches are destroyed one at a time in queue order.
+		FCriticalSection DestroyLock;
+		TArray<FPendingDestroy> Batch;
+
+		FEvent* WakeEvent = nullptr;
+		FRunnableThread* Thread = nullptr;
+		TAtomic<bool> bStopping{false};
+	};
+}	 // namespace MicrosoftOpenXR
@@ -9,16 +9,110 @@
 #include "IOpenXRARTrackedGeometryHolder.h"
 #include "ARSessionConfig.h"
 #include "HeadMountedDisplayTypes.h"
+#include "VertexConversion.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/EngineVersionComparison.h"
+#include "RHICommandList.h"
+#include "DeferredHandleDestroyer.h"
 
 #define LOCTEXT_NAMESPACE "FMicrosoftOpenXRModule"
 
+static TAutoConsoleVariable<int32> CVarHandMeshLateLatching(
+	TEXT("xr.MicrosoftOpenXR.HandMesh.LateLatching"),
+	0,
+	TEXT("When the hand mesh is used for XR visualization, read it again just before the frame is submitted.\n")
+	TEXT("The vertices are only available to renderers through UMicrosoftOpenXRFunctionLibrary::UpdateLateLatchedHandMeshVertexBuffer_RenderThread."));
+
+DECLARE_CYCLE_STAT(TEXT("Get Hand Mesh Data"), STAT_GetHandMeshData, STATGROUP_MicrosoftOpenXR);
+DECLARE_CYCLE_STAT(TEXT("Get Packed Hand Mesh Data"), STAT_GetPackedHandMeshData, STATGROUP_MicrosoftOpenXR);
 
 namespace MicrosoftOpenXR
 {
+	namespace
+	{
+		template <typename IndexType>
+		void BuildDoubleSidedIndices(const uint32_t* RawIndices, size_t IndicesCount, TArray<IndexType>& OutIndices)
+		{
+			OutIndices.SetNumUninitialized(IndicesCount * 2);
+
+			size_t TriangleCount = IndicesCount / 3;
+
+			auto DestIndices = OutIndices.GetData();
+
+			for (size_t j = 0; j < TriangleCount; ++j)
+			{
+				//forward face
+				DestIndices[0] = static_cast<IndexType>(RawIndices[2]);
+				DestIndices[1] = static_cast<IndexType>(RawIndices[1]);
+				DestIndices[2] = static_cast<IndexType>(RawIndices[0]);
+
+				//backward face
+				DestIndices[3] = static_cast<IndexType>(RawIndices[0]);
+				DestIndices[4] = static_cast<IndexType>(RawIndices[1]);
+				DestIndices[5] = static_cast<IndexType>(RawIndices[2]);
+
+				DestIndices += 6;
+				RawIndices += 3;
+			}
+		}
+	}	 // namespace
+
+	static_assert(EHandKeypointCount == XR_HAND_JOINT_COUNT_EXT, "EHandKeypoint must match XrHandJointEXT");
+
+	void FHandMeshPlugin::FHandMeshFrame::Reset()
+	{
+		TrackingState = EARTrackingState::NotTracking;
+		LocalToTrackingTransform.SetIdentity();
+		Vertices.Reset();
+		Normals.Reset();
+		Indices.Reset();
+		bMeshChanged = false;
+	}
+
+	void FHandMeshPlugin::FHandJoints::Reset()
+	{
+		DisplayTime = 0;
+		bValid = false;
+	}
+
+	void FHandMeshPlugin::FHandMeshBuffers::Reset()
+	{
+		IndicesCount = 0;
+		VerticesCount = 0;
+		IndexBufferKey = 0;
+		DoubleSidedIndices.Reset();
+		VertexUpdateTime = 0;
+		bMeshChanged = false;
+	}
+
 	FHandMeshPlugin::FHandState::FHandState()
 	{
 	}
 
+	void FHandMeshPlugin::FHandState::Reset()
+	{
+		Buffers.Reset();
+		Joints.Reset();
+		Frames[0].Reset();
+		Frames[1].Reset();
+		bSubmittedTrackedMesh = false;
+		SubmittedIndexBufferKey = 0;
+	}
+
+	void FHandMeshPlugin::OnDestroySession(XrSession InSession)
+	{
+		// The tasks read through the hand trackers, which are destroyed with the session.
+		WaitForPendingFrames();
+
+		// Keypoint queries must neither return the last joints nor locate them with the destroyed trackers and spaces.
+		JointLocateInfo = FJointLocateInfo();
+		for (int i = 0; i < HandCount; ++i)
+		{
+			HandStates[i].Joints.Reset();
+		}
+	}
+
 	bool FHandMeshPlugin::GetRequiredExtensions(TArray<const ANSICHAR*>& OutExtensions)
 	{
 		OutExtensions.Add(XR_EXT_HAND_TRACKING_EXTENSION_NAME);
@@ -39,6 +133,7 @@ namespace MicrosoftOpenXR
 		if (bHandMeshTrackingAvailable)
 		{
 			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrCreateHandTrackerEXT", (PFN_xrVoidFunction*)&xrCreateHandTrackerEXT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrLocateHandJointsEXT", (PFN_xrVoidFunction*)&xrLocateHandJointsEXT));
 			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrCreateHandMeshSpaceMSFT", (PFN_xrVoidFunction*)&xrCreateHandMeshSpaceMSFT));
 			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrUpdateHandMeshMSFT", (PFN_xrVoidFunction*)&xrUpdateHandMeshMSFT));
 
@@ -46,16 +141,17 @@ namespace MicrosoftOpenXR
 			{
 				FHandState& HandState = HandStates[i];
 
-				HandState.IndicesCount = 0;
-				HandState.VerticesCount = 0;
-
 				HandState.VerticesMaxAmount = HandMeshTrackingSystemProperties.maxHandMeshVertexCount;
 				HandState.IndicesMaxAmount = HandMeshTrackingSystemProperties.maxHandMeshIndexCount;
 
 				HandState.Guid = FGuid::NewGuid();
 
-				HandState.Vertices.resize(HandState.VerticesMaxAmount);
-				HandState.Indices.resize(HandState.IndicesMaxAmount);
+				for (FHandMeshBuffers* Buffers : {&HandState.Buffers, &HandState.Buffers_RHIThread})
+				{
+					Buffers->Reset();
+					Buffers->Vertices.resize(HandState.VerticesMaxAmount);
+					Buffers->Indices.resize(HandState.IndicesMaxAmount);
+				}
 			}
 
 			HandMeshStatus = EHandMeshStatus::Disabled;
@@ -70,10 +166,18 @@ namespace MicrosoftOpenXR
 
 	const void* FHandMeshPlugin::OnBeginSession(XrSession InSession, const void* InNext)
 	{
+		// Joints are not located until the first update of the new session.
+		JointLocateInfo = FJointLocateInfo();
+		for (int i = 0; i < HandCount; ++i)
+		{
+			HandStates[i].Joints.Reset();
+		}
+
 		if (HandMeshStatus == EHandMeshStatus::NotInitialised)
 		{
 			return InNext;
 		}
+		WaitForPendingFrames();
 		static FName SystemName(TEXT("OpenXR"));
 		if (GEngine->XRSystem.IsValid() && (GEngine->XRSystem->GetSystemName() == SystemName))
 		{
@@ -98,6 +202,7 @@ namespace MicrosoftOpenXR
 		for (int i = 0; i < HandCount; ++i)
 		{
 			FHandState& HandState = HandStates[i];
+			FScopeLock Lock(&HandState.TrackerLock);
 
 			XrHandTrackerCreateInfoEXT CreateInfo{ XR_TYPE_HAND_TRACKER_CREATE_INFO_EXT };
 			CreateInfo.hand = XrHandEXT(XR_HAND_LEFT_EXT + i);
@@ -108,121 +213,367 @@ namespace MicrosoftOpenXR
 			SpaceCreateInfo.handPoseType = XR_HAND_POSE_TYPE_TRACKED_MSFT;
 			SpaceCreateInfo.poseInHandMeshSpace = ToXrPose(FTransform::Identity, XRTrackingSystem->GetWorldToMetersScale());
 			XR_ENSURE_MSFT(xrCreateHandMeshSpaceMSFT(HandState.HandTracker, &SpaceCreateInfo, &HandState.Space));
+
+			// The new tracker has not returned an index buffer yet, no frame is rendered before the session begins.
+			HandState.Reset();
+			HandState.Buffers_RHIThread.Reset();
+			HandState.LateLatchedVertices_RHIThread.Reset();
 		}
 
 		return InNext;
 	}
 
-	void FHandMeshPlugin::UpdateDeviceLocations(XrSession InSession, XrTime DisplayTime, XrSpace TrackingSpace)
+	bool FHandMeshPlugin::ReadHandMesh(FHandState& HandState, FHandMeshBuffers& Buffers, XrTime DisplayTime, XrSpace TrackingSpace, float WorldToMetersScale, FTransform& OutLocalToTrackingTransform) const
 	{
-		check(IsInGameThread());
+		FScopeLock Lock(&HandState.TrackerLock);
+		XrSpaceLocation SpaceLocation { XR_TYPE_SPACE_LOCATION };
 
-		if (HandMeshStatus <= EHandMeshStatus::Disabled)
+		XR_ENSURE_MSFT(xrLocateSpace(HandState.Space, TrackingSpace, DisplayTime, &SpaceLocation));
+		const XrSpaceLocationFlags ValidFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+
+		if ((SpaceLocation.locationFlags & ValidFlags) != ValidFlags)
 		{
-			return;
+			//tracking lost
+			// The index buffer is kept with its key, the runtime only sends it again if it changes.
+			Buffers.VerticesCount = 0;
+			return false;
 		}
 
-		for (int i = 0; i < HandCount; ++i)
-		{
-			FHandState& HandState = HandStates[i];
+		OutLocalToTrackingTransform = ToFTransform(SpaceLocation.pose, WorldToMetersScale);
+
+		XrHandMeshUpdateInfoMSFT HandMeshUpdateInfo { XR_TYPE_HAND_MESH_UPDATE_INFO_MSFT };
+		HandMeshUpdateInfo.time = DisplayTime;
+		HandMeshUpdateInfo.handPoseType = XR_HAND_POSE_TYPE_TRACKED_MSFT;
 
-			XrSpaceLocation SpaceLocation { XR_TYPE_SPACE_LOCATION };
+		XrHandMeshMSFT HandMesh { XR_TYPE_HAND_MESH_MSFT };
+		// The runtime only writes the indices when they no longer match this key.
+		HandMesh.indexBuffer.indexBufferKey = Buffers.IndexBufferKey;
+		HandMesh.indexBuffer.indexCapacityInput = Buffers.Indices.size();
+		HandMesh.indexBuffer.indices = Buffers.Indices.data();
 
-			XR_ENSURE_MSFT(xrLocateSpace(HandState.Space, TrackingSpace, DisplayTime, &SpaceLocation));
-			const XrSpaceLocationFlags ValidFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+		HandMesh.vertexBuffer.vertexCapacityInput = Buffers.Vertices.size();
+		HandMesh.vertexBuffer.vertices = Buffers.Vertices.data();
 
-			if ((SpaceLocation.locationFlags & ValidFlags) == ValidFlags)
+		XR_ENSURE_MSFT(xrUpdateHandMeshMSFT(HandState.HandTracker, &HandMeshUpdateInfo, &HandMesh));
+
+		if (HandMesh.indexBufferChanged)
+		{
+			Buffers.IndicesCount = HandMesh.indexBuffer.indexCountOutput;
+			Buffers.IndexBufferKey = HandMesh.indexBuffer.indexBufferKey;
+
+			// A new array is built, the completed frame may still share the previous one.
+			TSharedRef<FHandMeshIndices, ESPMode::ThreadSafe> DoubleSidedIndices = MakeShared<FHandMeshIndices, ESPMode::ThreadSafe>();
+			DoubleSidedIndices->Key = Buffers.IndexBufferKey;
+			BuildDoubleSidedIndices(Buffers.Indices.data(), Buffers.IndicesCount, DoubleSidedIndices->Indices);
+			if (HandMesh.vertexBuffer.vertexCountOutput <= static_cast<uint32_t>(MAX_uint16) + 1)
 			{
-				HandState.TrackingState = EARTrackingState::Tracking;
-				HandState.LocalToTrackingTransform = ToFTransform(SpaceLocation.pose, XRTrackingSystem->GetWorldToMetersScale());
+				BuildDoubleSidedIndices(Buffers.Indices.data(), Buffers.IndicesCount, DoubleSidedIndices->PackedIndices);
+			}
+			Buffers.DoubleSidedIndices = DoubleSidedIndices;
+			//changes in index buffer can't be independent, if index buffer changes, vertex buffers changes as well
+		}
+
+		if (HandMesh.vertexBufferChanged)
+		{
+			Buffers.VerticesCount = HandMesh.vertexBuffer.vertexCountOutput;
+		}
+
+		// Compared with the update time these buffers last read, since the late latching read on the RHI thread also updates the mesh.
+		Buffers.bMeshChanged = HandMesh.indexBufferChanged || HandMesh.vertexBuffer.vertexUpdateTime != Buffers.VertexUpdateTime;
+		Buffers.VertexUpdateTime = HandMesh.vertexBuffer.vertexUpdateTime;
+
+		return true;
+	}
 
-				XrHandMeshUpdateInfoMSFT HandMeshUpdateInfo { XR_TYPE_HAND_MESH_UPDATE_INFO_MSFT };
-				HandMeshUpdateInfo.time = DisplayTime;
-				HandMeshUpdateInfo.handPoseType = XR_HAND_POSE_TYPE_TRACKED_MSFT;
+	const FHandMeshPlugin::FHandJoints& FHandMeshPlugin::LocateHandJoints(const FHandState& HandState) const
+	{
+		FHandJoints& Joints = HandState.Joints;
+		if (Joints.DisplayTime == JointLocateInfo.DisplayTime)
+		{
+			// Every keypoint query after the first one this frame reads the joints it located.
+			return Joints;
+		}
+		Joints.DisplayTime = JointLocateInfo.DisplayTime;
+		Joints.bValid = false;
 
-				XrHandMeshMSFT HandMesh { XR_TYPE_HAND_MESH_MSFT };
-				HandMesh.indexBuffer.indexCapacityInput = HandState.Indices.size();
-				HandMesh.indexBuffer.indices = HandState.Indices.data();
+		XrHandJointLocationEXT JointLocations[XR_HAND_JOINT_COUNT_EXT];
 
-				HandMesh.vertexBuffer.vertexCapacityInput = HandState.Vertices.size();
-				HandMesh.vertexBuffer.vertices = HandState.Vertices.data();
+		XrHandJointLocationsEXT Locations{ XR_TYPE_HAND_JOINT_LOCATIONS_EXT };
+		Locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
+		Locations.jointLocations = JointLocations;
 
-				XR_ENSURE_MSFT(xrUpdateHandMeshMSFT(HandState.HandTracker, &HandMeshUpdateInfo, &HandMesh));
-				
+		XrHandJointsLocateInfoEXT LocateInfo{ XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT };
+		LocateInfo.baseSpace = JointLocateInfo.TrackingSpace;
+		LocateInfo.time = JointLocateInfo.DisplayTime;
 
-				if (HandMesh.indexBufferChanged)
-				{
-					HandState.IndicesCount = HandMesh.indexBuffer.indexCountOutput;
-					//changes in index buffer can't be independent, if index buffer changes, vertex buffers changes as well
-				}
+		bool bLocated;
+		{
+			FScopeLock Lock(&HandState.TrackerLock);
+			bLocated = XR_ENSURE_MSFT(xrLocateHandJointsEXT(HandState.HandTracker, &LocateInfo, &Locations));
+		}
+		if (!bLocated || Locations.isActive == XR_FALSE)
+		{
+			return Joints;
+		}
 
-				if (HandMesh.vertexBufferChanged)
-				{
-					HandState.VerticesCount = HandMesh.vertexBuffer.vertexCountOutput;
-				}
+		const XrSpaceLocationFlags ValidFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+		for (int32 Joint = 0; Joint < XR_HAND_JOINT_COUNT_EXT; ++Joint)
+		{
+			if ((JointLocations[Joint].locationFlags & ValidFlags) != ValidFlags)
+			{
+				return Joints;
 			}
-			else
+		}
+
+		for (int32 Joint = 0; Joint < XR_HAND_JOINT_COUNT_EXT; ++Joint)
+		{
+			Joints.Transforms[Joint] = ToFTransform(JointLocations[Joint].pose, JointLocateInfo.WorldToMetersScale);
+			Joints.Radii[Joint] = JointLocations[Joint].radius * JointLocateInfo.WorldToMetersScale;
+		}
+		Joints.bValid = true;
+		return Joints;
+	}
+
+	void FHandMeshPlugin::UpdateHandState(FHandState& HandState, XrTime DisplayTime, XrSpace TrackingSpace, float WorldToMetersScale, bool bConvertNormals) const
+	{
+		FHandMeshFrame& Frame = HandState.GetPendingFrame();
+		FHandMeshBuffers& Buffers = HandState.Buffers;
+
+		if (!ReadHandMesh(HandState, Buffers, DisplayTime, TrackingSpace, WorldToMetersScale, Frame.LocalToTrackingTransform))
+		{
+			Frame.TrackingState = EARTrackingState::NotTracking;
+			Frame.Vertices.Reset();
+			Frame.Normals.Reset();
+			Frame.Indices.Reset();
+			Frame.bMeshChanged = false;
+			return;
+		}
+
+		Frame.TrackingState = EARTrackingState::Tracking;
+		Frame.Indices = Buffers.DoubleSidedIndices;
+		Frame.bMeshChanged = Buffers.bMeshChanged;
+
+		//resize the data without deallocation
+		Frame.Vertices.SetNumUninitialized(Buffers.VerticesCount, false);
+		ConvertXrVectorsToFVectors(&Buffers.Vertices.data()->position, sizeof(XrHandMeshVertexMSFT),
+			Frame.Vertices.GetData(), static_cast<int32>(Buffers.VerticesCount), WorldToMetersScale);
+
+		if (bConvertNormals)
+		{
+			Frame.Normals.SetNumUninitialized(Buffers.VerticesCount, false);
+			// A scale of -1 converts and flips the normals in one pass.
+			ConvertXrVectorsToFVectors(&Buffers.Vertices.data()->normal, sizeof(XrHandMeshVertexMSFT),
+				Frame.Normals.GetData(), static_cast<int32>(Buffers.VerticesCount), -1.0f);
+		}
+		else
+		{
+			Frame.Normals.Reset();
+		}
+	}
+
+	void FHandMeshPlugin::UpdateDeviceLocations(XrSession InSession, XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		check(IsInGameThread());
+
+		const float WorldToMetersScale = HandMeshStatus != EHandMeshStatus::NotInitialised ? XRTrackingSystem->GetWorldToMetersScale() : 100.0f;
+		const bool bConvertNormals = HandMeshStatus == EHandMeshStatus::EnabledXRVisualization;
+
+		// Each hand has its own tracker and buffers, so both hands are read and converted by tasks that run alongside each other
+		// and the rest of this update, and are joined before the meshes are submitted.
+		if (HandMeshStatus > EHandMeshStatus::Disabled)
+		{
+			for (int i = 0; i < HandCount; ++i)
 			{
-				//tracking lost
-				HandState.TrackingState = EARTrackingState::NotTracking;
+				FHandState& HandState = HandStates[i];
+				TPromise<void> Promise;
+				HandState.PendingFrameFuture = Promise.GetFuture();
+				AsyncTask(ENamedThreads::AnyThread,
+					[this, &HandState, DisplayTime, TrackingSpace, WorldToMetersScale, bConvertNormals, Promise = MoveTemp(Promise)]() mutable {
+						UpdateHandState(HandState, DisplayTime, TrackingSpace, WorldToMetersScale, bConvertNormals);
+						Promise.SetValue();
+					});
+			}
+		}
 
-				HandState.IndicesCount = 0;
-				HandState.VerticesCount = 0;
+		{
+			FLateLatchSettings Settings;
+			Settings.bEnabled = HandMeshStatus == EHandMeshStatus::EnabledXRVisualization && CVarHandMeshLateLatching.GetValueOnGameThread() != 0;
+			if (Settings.bEnabled)
+			{
+				Settings.TrackingSpace = TrackingSpace;
+				Settings.WorldToMetersScale = WorldToMetersScale;
 			}
+
+			FScopeLock Lock(&LateLatchSettingsLock);
+			LateLatchSettings = Settings;
 		}
 
-		if (HandMeshStatus != EHandMeshStatus::EnabledTrackingGeometry)
+		if (HandMeshStatus == EHandMeshStatus::NotInitialised)
 		{
 			return;
 		}
 
+		// The joints come from the same tracker as the mesh, so keypoint queries don't need a second hand tracking pipeline.
+		JointLocateInfo.DisplayTime = DisplayTime;
+		JointLocateInfo.TrackingSpace = TrackingSpace;
+		JointLocateInfo.WorldToMetersScale = WorldToMetersScale;
+
+		// The frames read for this display time become the completed frames, the game thread reads them until the next update.
+		if (WaitForPendingFrames())
+		{
+			for (int i = 0; i < HandCount; ++i)
+			{
+				HandStates[i].CompletedFrame = 1 - HandStates[i].CompletedFrame;
+			}
+
+			if (HandMeshStatus == EHandMeshStatus::EnabledTrackingGeometry)
+			{
+				SubmitTrackedHandMeshes();
+			}
+		}
+	}
+
+	bool FHandMeshPlugin::WaitForPendingFrames()
+	{
+		bool bWaited = false;
+		for (int i = 0; i < HandCount; ++i)
+		{
+			TFuture<void>& Future = HandStates[i].PendingFrameFuture;
+			if (Future.IsValid())
+			{
+				Future.Wait();
+				Future.Reset();
+				bWaited = true;
+			}
+		}
+		return bWaited;
+	}
+
+	void FHandMeshPlugin::SubmitTrackedHandMeshes()
+	{
+		bool bMovedHands[HandCount] = {};
 		TrackedMeshHolder->StartMeshUpdates();
 		for (int i = 0; i < HandCount; ++i)
 		{
 			FHandState& HandState = HandStates[i];
+			const FHandMeshFrame& Frame = HandState.GetCompletedFrame();
+			const uint32_t IndexBufferKey = Frame.Indices.IsValid() ? Frame.Indices->Key : 0;
+
+			// The runtime returned the mesh already submitted, so it only has to be moved to the new hand pose.
+			bMovedHands[i] = Frame.TrackingState == EARTrackingState::Tracking && HandState.bSubmittedTrackedMesh && !Frame.bMeshChanged &&
+							 IndexBufferKey == HandState.SubmittedIndexBufferKey;
+			HandState.bSubmittedTrackedMesh = Frame.TrackingState == EARTrackingState::Tracking;
+			HandState.SubmittedIndexBufferKey = IndexBufferKey;
+			if (bMovedHands[i])
+			{
+				continue;
+			}
 
 			FOpenXRMeshUpdate* MeshUpdate = TrackedMeshHolder->AllocateMeshUpdate(HandState.Guid);
 			MeshUpdate->Type = EARObjectClassification::HandMesh;
-			MeshUpdate->TrackingState = HandState.TrackingState;
-			if (HandState.TrackingState != EARTrackingState::Tracking)
+			MeshUpdate->TrackingState = Frame.TrackingState;
+			if (Frame.TrackingState != EARTrackingState::Tracking)
 			{
 				continue;
 			}
 
-			MeshUpdate->LocalToTrackingTransform = HandState.LocalToTrackingTransform;
-			MeshUpdate->Indices.AddUninitialized(HandState.IndicesCount * 2);
+			MeshUpdate->LocalToTrackingTransform = Frame.LocalToTrackingTransform;
+			// The mesh holder owns the buffers of every mesh update, so a changed mesh still copies its vertices and doubled indices.
+			MeshUpdate->Vertices = Frame.Vertices;
+			if (Frame.Indices.IsValid())
+			{
+				MeshUpdate->Indices = Frame.Indices->Indices;
+			}
+		}
+		TrackedMeshHolder->EndMeshUpdates();
 
-			size_t TriangleCount = (size_t)HandState.IndicesCount / 3;
+		for (int i = 0; i < HandCount; ++i)
+		{
+			if (!bMovedHands[i])
+			{
+				continue;
+			}
 
-			auto DestIndices = MeshUpdate->Indices.GetData();
-			auto RawIndices = HandState.Indices.data();
+#if !UE_VERSION_OLDER_THAN(4, 27, 0)
+			auto MeshUpdate = MakeShared<FOpenXRMeshUpdate>();
+#else
+			auto MeshUpdate = new FOpenXRMeshUpdate();
+#endif
+			MeshUpdate->Id = HandStates[i].Guid;
+			MeshUpdate->Type = EARObjectClassification::HandMesh;
+			MeshUpdate->TrackingState = EARTrackingState::Tracking;
+			MeshUpdate->LocalToTrackingTransform = HandStates[i].GetCompletedFrame().LocalToTrackingTransform;
+			TrackedMeshHolder->ObjectUpdated(MoveTemp(MeshUpdate));
+		}
+	}
 
-			for (size_t j = 0; j < TriangleCount; ++j)
-			{
-				//forward face
-				DestIndices[0] = RawIndices[2];
-				DestIndices[1] = RawIndices[1];
-				DestIndices[2] = RawIndices[0];
+	const void* FHandMeshPlugin::OnBeginFrame(XrSession InSession, XrTime DisplayTime, const void* InNext)
+	{
+		// This runs on the RHI thread just before xrBeginFrame, with the display time of the frame about to be rendered.
+		FLateLatchSettings Settings;
+		{
+			FScopeLock Lock(&LateLatchSettingsLock);
+			Settings = LateLatchSettings;
+		}
 
-				//backward face
-				DestIndices[3] = RawIndices[0];
-				DestIndices[4] = RawIndices[1];
-				DestIndices[5] = RawIndices[2];
+		for (int i = 0; i < HandCount; ++i)
+		{
+			FHandState& HandState = HandStates[i];
+			TArray<FVector>& Vertices = HandState.LateLatchedVertices_RHIThread;
+			FScopeLock Lock(&HandState.TrackerLock);
 
-				DestIndices += 6;
-				RawIndices += 3;
+			FTransform LocalToTrackingTransform;
+			if (!Settings.bEnabled ||
+				!ReadHandMesh(HandState, HandState.Buffers_RHIThread, DisplayTime, Settings.TrackingSpace, Settings.WorldToMetersScale, LocalToTrackingTransform))
+			{
+				Vertices.Reset();
+				continue;
 			}
 
-			MeshUpdate->Vertices.AddUninitialized(HandState.VerticesCount);
-			for (size_t j = 0; j < HandState.VerticesCount; ++j)
+			const FHandMeshBuffers& Buffers = HandState.Buffers_RHIThread;
+			Vertices.SetNumUninitialized(Buffers.VerticesCount, false);
+			ConvertXrVectorsToFVectors(&Buffers.Vertices.data()->position, sizeof(XrHandMeshVertexMSFT),
+				Vertices.GetData(), static_cast<int32>(Buffers.VerticesCount), Settings.WorldToMetersScale);
+			for (FVector& Vertex : Vertices)
 			{
-				auto& destVert = MeshUpdate->Vertices[j];
-				const auto& srcVert = HandState.Vertices[j];
-
-				destVert = ToFVector(srcVert.position, XRTrackingSystem->GetWorldToMetersScale());
+				Vertex = LocalToTrackingTransform.TransformPosition(Vertex);
 			}
 		}
-		TrackedMeshHolder->EndMeshUpdates();
+
+		return InNext;
+	}
+
+	void FHandMeshPlugin::UpdateLateLatchedVertexBuffer_RenderThread(FRHICommandListImmediate& RHICmdList, EControllerHand Hand, FRHIVertexBuffer* VertexBuffer)
+	{
+		check(IsInRenderingThread());
+
+		const FHandState* HandState = GetHandState(Hand);
+		if (VertexBuffer == nullptr || HandState == nullptr)
+		{
+			return;
+		}
+
+		// The lambda runs on the RHI thread, or right away when there is no RHI thread.
+		// It copies whatever OnBeginFrame read last, which may be for the previous frame if this frame has not begun yet.
+		RHICmdList.EnqueueLambda([HandState, VertexBufferRef = FVertexBufferRHIRef(VertexBuffer)](FRHICommandListImmediate& CmdList) {
+			FScopeLock Lock(&HandState->TrackerLock);
+			const TArray<FVector>& Vertices = HandState->LateLatchedVertices_RHIThread;
+			const uint32 Size = FMath::Min<uint32>(VertexBufferRef->GetSize(), Vertices.Num() * sizeof(FVector));
+			if (Size == 0)
+			{
+				return;
+			}
+
+#if UE_VERSION_OLDER_THAN(4, 27, 0)
+			void* Data = GDynamicRHI->LockVertexBuffer_BottomOfPipe(CmdList, VertexBufferRef, 0, Size, RLM_WriteOnly);
+			FMemory::Memcpy(Data, Vertices.GetData(), Size);
+			GDynamicRHI->UnlockVertexBuffer_BottomOfPipe(CmdList, VertexBufferRef);
+#else
+			void* Data = GDynamicRHI->LockBuffer_BottomOfPipe(CmdList, VertexBufferRef, 0, Size, RLM_WriteOnly);
+			FMemory::Memcpy(Data, Vertices.GetData(), Size);
+			GDynamicRHI->UnlockBuffer_BottomOfPipe(CmdList, VertexBufferRef);
+#endif
+		});
 	}
 
 	void FHandMeshPlugin::Register()
@@ -233,6 +584,7 @@ namespace MicrosoftOpenXR
 
 	void FHandMeshPlugin::Unregister()
 	{
+		WaitForPendingFrames();
 		IModularFeatures::Get().UnregisterModularFeature(IHandTracker::GetModularFeatureName(), static_cast<IHandTracker*>(this));
 		IModularFeatures::Get().UnregisterModularFeature(IOpenXRExtensionPlugin::GetModularFeatureName(), static_cast<IOpenXRExtensionPlugin*>(this));
 	}
@@ -248,14 +600,13 @@ namespace MicrosoftOpenXR
 
 		if (Mode == EHandMeshStatus::Disabled)
 		{
+			// The frames being read are discarded with the rest of the hand state.
+			WaitForPendingFrames();
 			for (int i = 0; i < HandCount; ++i)
 			{
 				FHandState& HandState = HandStates[i];
 
-				HandState.IndicesCount = 0;
-				HandState.VerticesCount = 0;
-				HandState.LocalToTrackingTransform.SetIdentity();
-				HandState.TrackingState = EARTrackingState::NotTracking;
+				HandState.Reset();
 
 				if (HandMeshStatus == EHandMeshStatus::EnabledTrackingGeometry)
 				{
@@ -269,9 +620,28 @@ namespace MicrosoftOpenXR
 		return true;
 	}
 
+	const FHandMeshPlugin::FHandState* FHandMeshPlugin::GetHandState(EControllerHand Hand) const
+	{
+		if (Hand == EControllerHand::Left)
+		{
+			return HandStates + Left;
+		}
+		else if (Hand == EControllerHand::Right)
+		{
+			return HandStates + Right;
+		}
+
+		//do nothing for an unknown controller
+		return nullptr;
+	}
+
 	bool FHandMeshPlugin::IsHandTrackingStateValid() const
 	{
-		if (HandMeshStatus <= EHandMeshStatus::Disabled)
+		// Locating the joints writes the cached joints of the hand state.
+		check(IsInGameThread());
+
+		// Joints are located while the hand mesh is disabled, as long as the hand trackers exist.
+		if (HandMeshStatus == EHandMeshStatus::NotInitialised || JointLocateInfo.DisplayTime == 0)
 		{
 			return false;
 		}
@@ -279,7 +649,7 @@ namespace MicrosoftOpenXR
 		for (int i = 0; i < HandCount; ++i)
 		{
 			const FHandState& HandState = HandStates[i];
-			if (HandState.TrackingState == EARTrackingState::Tracking)
+			if (HandState.GetCompletedFrame().TrackingState == EARTrackingState::Tracking || LocateHandJoints(HandState).bValid)
 			{
 				return true;
 			}
@@ -288,6 +658,61 @@ namespace MicrosoftOpenXR
 		return false;
 	}
 
+	bool FHandMeshPlugin::GetKeypointState(EControllerHand Hand, EHandKeypoint Keypoint, FTransform& OutTransform, float& OutRadius) const
+	{
+		check(IsInGameThread());
+
+		const FHandState* HandState = GetHandState(Hand);
+		if (HandMeshStatus == EHandMeshStatus::NotInitialised || HandState == nullptr || JointLocateInfo.DisplayTime == 0)
+		{
+			return false;
+		}
+
+		const FHandJoints& Joints = LocateHandJoints(*HandState);
+		if (!Joints.bValid)
+		{
+			return false;
+		}
+
+		const int32 Joint = static_cast<int32>(Keypoint);
+		OutTransform = Joints.Transforms[Joint] * XRTrackingSystem->GetTrackingToWorldTransform();
+		OutRadius = Joints.Radii[Joint];
+
+		return true;
+	}
+
+	bool FHandMeshPlugin::GetAllKeypointStates(EControllerHand Hand, TArray<struct FVector>& OutPositions, TArray<struct FQuat>& OutRotations, TArray<float>& OutRadii) const
+	{
+		check(IsInGameThread());
+
+		const FHandState* HandState = GetHandState(Hand);
+		if (HandMeshStatus == EHandMeshStatus::NotInitialised || HandState == nullptr || JointLocateInfo.DisplayTime == 0)
+		{
+			return false;
+		}
+
+		const FHandJoints& Joints = LocateHandJoints(*HandState);
+		if (!Joints.bValid)
+		{
+			return false;
+		}
+
+		const FTransform TrackingToWorldTransform = XRTrackingSystem->GetTrackingToWorldTransform();
+
+		OutPositions.SetNumUninitialized(XR_HAND_JOINT_COUNT_EXT);
+		OutRotations.SetNumUninitialized(XR_HAND_JOINT_COUNT_EXT);
+		OutRadii.SetNumUninitialized(XR_HAND_JOINT_COUNT_EXT);
+		for (int32 Joint = 0; Joint < XR_HAND_JOINT_COUNT_EXT; ++Joint)
+		{
+			const FTransform JointTransform = Joints.Transforms[Joint] * TrackingToWorldTransform;
+			OutPositions[Joint] = JointTransform.GetLocation();
+			OutRotations[Joint] = JointTransform.GetRotation();
+			OutRadii[Joint] = Joints.Radii[Joint];
+		}
+
+		return true;
+	}
+
 	bool FHandMeshPlugin::HasHandMeshData() const
 	{
 		if (HandMeshStatus <= EHandMeshStatus::Disabled)
@@ -298,7 +723,7 @@ namespace MicrosoftOpenXR
 		for (int i = 0; i < HandCount; ++i)
 		{
 			const FHandState& HandState = HandStates[i];
-			if (HandState.VerticesCount > 0)
+			if (HandState.GetCompletedFrame().Vertices.Num() > 0)
 			{
 				return true;
 			}
@@ -310,28 +735,19 @@ namespace MicrosoftOpenXR
 	bool FHandMeshPlugin::GetHandMeshData(EControllerHand Hand, TArray<struct FVector>& OutVertices, TArray<struct FVector>& OutNormals, TArray<int32>& OutIndices, FTransform& OutHandMeshTransform) const
 	{
 		check(IsInGameThread());
+		SCOPE_CYCLE_COUNTER(STAT_GetHandMeshData);
 
 		if (HandMeshStatus <= EHandMeshStatus::Disabled)
 		{
 			return false;
 		}
 
-		const FHandState* HandState = nullptr;
-		if (Hand == EControllerHand::Left)
-		{
-			HandState = HandStates + Left;
-		}
-		else if (Hand == EControllerHand::Right)
-		{
-			HandState = HandStates + Right;
-		}
-		else
+		const FHandState* HandState = GetHandState(Hand);
+		if (HandState == nullptr)
 		{
-			//do nothing for an unknown controller
 			return false;
 		}
 
-
 		if (HandMeshStatus != EHandMeshStatus::EnabledXRVisualization)
 		{
 			OutIndices.Empty();
@@ -342,54 +758,90 @@ namespace MicrosoftOpenXR
 			return false;
 		}
 
+		// The completed frame was converted by the tasks of this frame's update, so this is only a copy.
+		const FHandMeshFrame& Frame = HandState->GetCompletedFrame();
+		if (!CopyHandMeshFrame(Frame, OutVertices, OutNormals, OutIndices))
+		{
+			return false;
+		}
+
+		OutHandMeshTransform = Frame.LocalToTrackingTransform * XRTrackingSystem->GetTrackingToWorldTransform();
+		return true;
+	}
+
+	bool FHandMeshPlugin::CopyHandMeshFrame(
+		const FHandMeshFrame& Frame, TArray<FVector>& OutVertices, TArray<FVector>& OutNormals, TArray<int32>& OutIndices)
+	{
 		//clear the data without deallocation
-		OutIndices.Reset(HandState->IndicesCount * 2);
-		OutVertices.Reset(HandState->VerticesCount);
-		OutNormals.Reset(HandState->VerticesCount);
+		OutIndices.Reset();
+		OutVertices.Reset();
+		OutNormals.Reset();
 
-		if (HandState->TrackingState != EARTrackingState::Tracking)
+		// Normals are missing for the first frame after switching to XR visualization.
+		if (Frame.TrackingState != EARTrackingState::Tracking || !Frame.Indices.IsValid() || Frame.Normals.Num() != Frame.Vertices.Num())
 		{
 			return false;
 		}
 
-		OutHandMeshTransform = HandState->LocalToTrackingTransform * XRTrackingSystem->GetTrackingToWorldTransform();
+		OutIndices.Append(Frame.Indices->Indices);
+		OutVertices.Append(Frame.Vertices);
+		OutNormals.Append(Frame.Normals);
+
+		return true;
+	}
 
-		OutIndices.AddUninitialized(HandState->IndicesCount * 2);
+	bool FHandMeshPlugin::GetPackedHandMeshData(EControllerHand Hand, FPackedHandMeshData& InOutMesh) const
+	{
+		check(IsInGameThread());
+		SCOPE_CYCLE_COUNTER(STAT_GetPackedHandMeshData);
 
-		size_t TriangleCount = (size_t)HandState->IndicesCount / 3;
+		InOutMesh.bIndicesChanged = false;
 
-		auto DestIndices = OutIndices.GetData();
-		auto RawIndices = HandState->Indices.data();
+		const FHandState* HandState = GetHandState(Hand);
+		if (HandMeshStatus != EHandMeshStatus::EnabledXRVisualization || HandState == nullptr)
+		{
+			return false;
+		}
 
-		for (size_t j = 0; j < TriangleCount; ++j)
+		const FHandMeshFrame& Frame = HandState->GetCompletedFrame();
+		if (!CopyPackedHandMeshFrame(Frame, InOutMesh))
 		{
-			//forward face
-			DestIndices[0] = RawIndices[2];
-			DestIndices[1] = RawIndices[1];
-			DestIndices[2] = RawIndices[0];
+			return false;
+		}
+
+		InOutMesh.HandMeshTransform = Frame.LocalToTrackingTransform * XRTrackingSystem->GetTrackingToWorldTransform();
+		return true;
+	}
 
-			//backward face
-			DestIndices[3] = RawIndices[0];
-			DestIndices[4] = RawIndices[1];
-			DestIndices[5] = RawIndices[2];
+	bool FHandMeshPlugin::CopyPackedHandMeshFrame(const FHandMeshFrame& Frame, FPackedHandMeshData& InOutMesh)
+	{
+		InOutMesh.bIndicesChanged = false;
 
-			DestIndices += 6;
-			RawIndices += 3;
+		if (Frame.TrackingState != EARTrackingState::Tracking || !Frame.Indices.IsValid() || Frame.Indices->PackedIndices.Num() == 0 ||
+			Frame.Normals.Num() != Frame.Vertices.Num())
+		{
+			return false;
 		}
 
-		OutVertices.AddUninitialized(HandState->VerticesCount);
-		OutNormals.AddUninitialized(HandState->VerticesCount);
-		for (size_t j = 0; j < HandState->VerticesCount; ++j)
+		// Sized without shrinking, so the caller's buffers stop allocating once they fit the largest hand mesh.
+		InOutMesh.Positions.SetNumUninitialized(Frame.Vertices.Num(), false);
+		FMemory::Memcpy(InOutMesh.Positions.GetData(), Frame.Vertices.GetData(), Frame.Vertices.Num() * sizeof(FVector));
+		// Normals are only packed for callers of this function, the frames keep them as FVector for GetHandMeshData.
+		InOutMesh.Normals.SetNumUninitialized(Frame.Normals.Num(), false);
+		for (int32 Index = 0; Index < Frame.Normals.Num(); ++Index)
 		{
-			auto& destVert = OutVertices[j];
-			auto& destNorm = OutNormals[j];
-			const auto& srcVert = HandState->Vertices[j];
+			InOutMesh.Normals[Index] = FPackedNormal(Frame.Normals[Index]);
+		}
 
-			destVert = ToFVector(srcVert.position, XRTrackingSystem->GetWorldToMetersScale());
-			destNorm = -ToFVector(srcVert.normal);
+		const TArray<uint16>& PackedIndices = Frame.Indices->PackedIndices;
+		if (InOutMesh.IndexBufferKey != Frame.Indices->Key || InOutMesh.Indices.Num() != PackedIndices.Num())
+		{
+			InOutMesh.Indices.SetNumUninitialized(PackedIndices.Num(), false);
+			FMemory::Memcpy(InOutMesh.Indices.GetData(), PackedIndices.GetData(), PackedIndices.Num() * sizeof(uint16));
+			InOutMesh.IndexBufferKey = Frame.Indices->Key;
+			InOutMesh.bIndicesChanged = true;
 		}
 
 		return true;
 	}
-
 }	 // namespace MicrosoftOpenXR
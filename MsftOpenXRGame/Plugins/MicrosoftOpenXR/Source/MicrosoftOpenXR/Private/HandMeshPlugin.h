@@ -7,10 +7,14 @@
 #include "ARTypes.h"
 #include "MicrosoftOpenXR.h"
 #include "IHandTracker.h"
+#include "IOpenXRARTrackedGeometryHolder.h"
+#include "Async/Future.h"
 
 #include <vector>
 
 class IOpenXRARTrackedMeshHolder;
+class FRHICommandListImmediate;
+class FRHIVertexBuffer;
 
 namespace MicrosoftOpenXR
 {
@@ -20,26 +24,122 @@ namespace MicrosoftOpenXR
 		static const int HandCount = 2;
 		enum Hand {Left = 0, Right = 1};
 
-		struct FHandState : public FNoncopyable
+		/// <summary>
+		/// A hand mesh index buffer, rebuilt only when the runtime returns a new one.
+		/// </summary>
+		struct FHandMeshIndices
 		{
-			FHandState();
+			// Runtime key of the index buffer these were built from.
+			uint32_t Key = 0;
+			// Each triangle added again with the opposite winding, so the mesh is visible from both sides.
+			TArray<MRMESH_INDEX_TYPE> Indices;
+			// The same triangles for the packed hand mesh, empty when a vertex can't be indexed with 16 bits.
+			TArray<uint16> PackedIndices;
+		};
+		using FIndexBufferPtr = TSharedPtr<const FHandMeshIndices, ESPMode::ThreadSafe>;
 
-			XrHandTrackerEXT HandTracker{};
-			XrSpace Space{};
+		/// <summary>
+		/// A hand mesh converted to Unreal units, as read for one frame.
+		/// </summary>
+		struct FHandMeshFrame
+		{
+			EARTrackingState TrackingState = EARTrackingState::Unknown;
+			FTransform LocalToTrackingTransform;
+
+			TArray<FVector> Vertices;
+			// Only converted when the hand mesh is used for XR visualization.
+			TArray<FVector> Normals;
+			// Shared with the hand state until the runtime returns a new index buffer.
+			FIndexBufferPtr Indices;
+			// Whether the runtime returned a different mesh than for the previous frame of this hand.
+			bool bMeshChanged = false;
+
+			void Reset();
+		};
 
+		/// <summary>
+		/// Hand joints in tracking space, located by the first keypoint query of a frame.
+		/// </summary>
+		struct FHandJoints
+		{
+			// Display time the joints were located for, zero until they are first located.
+			XrTime DisplayTime = 0;
+			bool bValid = false;
+			FTransform Transforms[XR_HAND_JOINT_COUNT_EXT];
+			float Radii[XR_HAND_JOINT_COUNT_EXT] = {};
+
+			void Reset();
+		};
+
+		/// <summary>
+		/// Buffers the runtime writes a hand mesh into. Each thread that reads hand meshes has its own.
+		/// </summary>
+		struct FHandMeshBuffers
+		{
 			std::vector<uint32_t> Indices;
 			std::vector<XrHandMeshVertexMSFT> Vertices;
 
 			size_t VerticesCount = 0;
 			size_t IndicesCount = 0;
 
+			// Key of the index buffer in Indices, zero asks the runtime for its latest index buffer.
+			uint32_t IndexBufferKey = 0;
+			FIndexBufferPtr DoubleSidedIndices;
+
+			// Runtime update time of the vertices last read into these buffers.
+			XrTime VertexUpdateTime = 0;
+			// Whether the last read returned different vertices or indices than the read before it.
+			bool bMeshChanged = false;
+
+			void Reset();
+		};
+
+		struct FHandState : public FNoncopyable
+		{
+			FHandState();
+
+			// Serializes the hand tracker and its mesh space between the game thread, the update tasks and the RHI thread.
+			// Also guards the RHI thread buffers, which the game thread resets when a session begins.
+			mutable FCriticalSection TrackerLock;
+			XrHandTrackerEXT HandTracker{};
+			XrSpace Space{};
+
 			size_t VerticesMaxAmount = 0;
 			size_t IndicesMaxAmount = 0;
 
+			// Read by the game thread tasks.
+			FHandMeshBuffers Buffers;
+			// Read again just before the frame is submitted when late latching, only used on the RHI thread.
+			FHandMeshBuffers Buffers_RHIThread;
+			// Vertices in tracking space, so they are current without also late latching the hand pose.
+			TArray<FVector> LateLatchedVertices_RHIThread;
+
 			FGuid Guid;
 
-			EARTrackingState TrackingState = EARTrackingState::Unknown;
-			FTransform LocalToTrackingTransform;
+			// Located on the game thread when queried, so frames without keypoint queries don't locate the joints.
+			mutable FHandJoints Joints;
+
+			// The completed frame is read by the game thread while the next one is written by a task.
+			// The task is launched and joined by the same update, which then makes its frame the completed frame.
+			FHandMeshFrame Frames[2];
+			int32 CompletedFrame = 0;
+			TFuture<void> PendingFrameFuture;
+
+			// Whether a tracked mesh was last sent to the tracked mesh holder, and its index buffer, so unchanged meshes are only moved.
+			bool bSubmittedTrackedMesh = false;
+			uint32_t SubmittedIndexBufferKey = 0;
+
+			const FHandMeshFrame& GetCompletedFrame() const
+			{
+				return Frames[CompletedFrame];
+			}
+
+			FHandMeshFrame& GetPendingFrame()
+			{
+				return Frames[1 - CompletedFrame];
+			}
+
+			void Reset();
 		};
 
 		void Register();
@@ -48,15 +148,83 @@ namespace MicrosoftOpenXR
 		bool GetRequiredExtensions(TArray<const ANSICHAR*>& OutExtensions) override;
 		const void* OnCreateSession(XrInstance InInstance, XrSystemId InSystem, const void* InNext) override;
 		const void* OnBeginSession(XrSession InSession, const void* InNext) override;
+		void OnDestroySession(XrSession InSession) override;
 		void UpdateDeviceLocations(XrSession InSession, XrTime DisplayTime, XrSpace TrackingSpace) override;
+		const void* OnBeginFrame(XrSession InSession, XrTime DisplayTime, const void* InNext) override;
 
 		bool Turn(EHandMeshStatus Mode);
+
+		/// <summary>
+		/// Copy the most recent hand mesh vertices read by OnBeginFrame into a dynamic vertex buffer, as FVector positions in tracking space.
+		/// The copy runs on the RHI thread, but is not ordered against OnBeginFrame: depending on when this is called,
+		/// the vertices are the ones read just before this frame or the previous frame was submitted.
+		/// The indices are the ones from GetHandMeshData, which only differ when the hand topology changed.
+		/// Nothing is copied when late latching is disabled or the hand is not tracked.
+		/// </summary>
+		void UpdateLateLatchedVertexBuffer_RenderThread(FRHICommandListImmediate& RHICmdList, EControllerHand Hand, FRHIVertexBuffer* VertexBuffer);
+
+		/// <summary>
+		/// Copy the hand mesh for XR visualization into caller owned buffers that are reused every frame.
+		/// The normals are packed by each call, so frames without a caller don't pay for it.
+		/// The indices were packed when the topology changed, and are only copied then.
+		/// </summary>
+		bool GetPackedHandMeshData(EControllerHand Hand, FPackedHandMeshData& InOutMesh) const;
+
+		/// <summary>
+		/// Copy a completed frame's mesh into the buffers of GetHandMeshData, returns false if the frame has no mesh to show.
+		/// </summary>
+		static bool CopyHandMeshFrame(
+			const FHandMeshFrame& Frame, TArray<FVector>& OutVertices, TArray<FVector>& OutNormals, TArray<int32>& OutIndices);
+
+		/// <summary>
+		/// Copy a completed frame's mesh into the buffers of GetPackedHandMeshData, leaving the transform to the caller.
+		/// Returns false if the frame has no mesh to show or its vertices can't be indexed with 16 bits.
+		/// </summary>
+		static bool CopyPackedHandMeshFrame(const FHandMeshFrame& Frame, FPackedHandMeshData& InOutMesh);
+
 	private:
+		// Locate a hand and read its mesh into Buffers, returns false if the hand is not tracked.
+		bool ReadHandMesh(FHandState& HandState, FHandMeshBuffers& Buffers, XrTime DisplayTime, XrSpace TrackingSpace, float WorldToMetersScale, FTransform& OutLocalToTrackingTransform) const;
+
+		// Locate the joints of one hand for the current frame, unless they were already located for it.
+		const FHandJoints& LocateHandJoints(const FHandState& HandState) const;
+
+		// Locate and read one hand into its pending frame, safe to run for both hands at once.
+		void UpdateHandState(FHandState& HandState, XrTime DisplayTime, XrSpace TrackingSpace, float WorldToMetersScale, bool bConvertNormals) const;
+
+		// Wait for the tasks writing the pending frames, returns true if any were running.
+		bool WaitForPendingFrames();
+
+		// Send the completed frames to the tracked mesh holder.
+		void SubmitTrackedHandMeshes();
+
+		const FHandState* GetHandState(EControllerHand Hand) const;
+
+		// Written by the game thread each frame, the joints are located with these when they are queried.
+		struct FJointLocateInfo
+		{
+			XrTime DisplayTime = 0;
+			XrSpace TrackingSpace = XR_NULL_HANDLE;
+			float WorldToMetersScale = 100.0f;
+		};
+		FJointLocateInfo JointLocateInfo;
+
+		// Written by the game thread each frame and read when the hand meshes are late latched.
+		struct FLateLatchSettings
+		{
+			bool bEnabled = false;
+			XrSpace TrackingSpace = XR_NULL_HANDLE;
+			float WorldToMetersScale = 100.0f;
+		};
+		FCriticalSection LateLatchSettingsLock;
+		FLateLatchSettings LateLatchSettings;
+
 		FHandState HandStates[HandCount];
 
 		EHandMeshStatus HandMeshStatus = EHandMeshStatus::NotInitialised;
 
 		PFN_xrCreateHandTrackerEXT xrCreateHandTrackerEXT = nullptr;
+		PFN_xrLocateHandJointsEXT xrLocateHandJointsEXT = nullptr;
 
 		PFN_xrCreateHandMeshSpaceMSFT xrCreateHandMeshSpaceMSFT = nullptr;
 		PFN_xrUpdateHandMeshMSFT xrUpdateHandMeshMSFT = nullptr;
@@ -72,15 +240,9 @@ namespace MicrosoftOpenXR
 
 		virtual bool IsHandTrackingStateValid() const override;
 
-		virtual bool GetKeypointState(EControllerHand Hand, EHandKeypoint Keypoint, FTransform& OutTransform, float& OutRadius) const override
-		{
-			return false;
-		}
+		virtual bool GetKeypointState(EControllerHand Hand, EHandKeypoint Keypoint, FTransform& OutTransform, float& OutRadius) const override;
 
-		virtual bool GetAllKeypointStates(EControllerHand Hand, TArray<struct FVector>& OutPositions, TArray<struct FQuat>& OutRotations, TArray<float>& OutRadii) const override
-		{
-			return false;
-		}
+		virtual bool GetAllKeypointStates(EControllerHand Hand, TArray<struct FVector>& OutPositions, TArray<struct FQuat>& OutRotations, TArray<float>& OutRadii) const override;
 
 		virtual bool HasHandMeshData() const override;
 
@@ -0,0 +1,104 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IOpenXRARTrackedGeometryHolder.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Thread safe free list of array allocations, so buffers that are refilled every scan keep their memory
+	/// instead of going back to the heap.
+	/// </summary>
+	template <typename ElementType>
+	class TBufferPool
+	{
+	public:
+		explicit TBufferPool(int32 InMaxBuffers) : MaxBuffers(InMaxBuffers)
+		{
+		}
+
+		/// <summary>
+		/// Replace Buffer with an empty pooled buffer, preferring the smallest one that holds MinCapacity elements.
+		/// Buffer should be empty, any allocation it already has is freed.
+		/// </summary>
+		void Acquire(TArray<ElementType>& Buffer, int32 MinCapacity = 0)
+		{
+			FScopeLock Lock(&BuffersLock);
+			int32 BestIndex = INDEX_NONE;
+			for (int32 Index = 0; Index < Buffers.Num(); ++Index)
+			{
+				if (BestIndex == INDEX_NONE)
+				{
+					BestIndex = Index;
+					continue;
+				}
+
+				// Prefer buffers that fit, then the tightest fit, otherwise the largest buffer.
+				const int32 Capacity = Buffers[Index].Max();
+				const int32 BestCapacity = Buffers[BestIndex].Max();
+				const bool bFits = Capacity >= MinCapacity;
+				const bool bBestFits = BestCapacity >= MinCapacity;
+				if (bFits != bBestFits ? bFits : (bFits ? Capacity < BestCapacity : Capacity > BestCapacity))
+				{
+					BestIndex = Index;
+				}
+			}
+
+			if (BestIndex != INDEX_NONE)
+			{
+				Buffer = MoveTemp(Buffers[BestIndex]);
+				Buffers.RemoveAtSwap(BestIndex, 1, false);
+			}
+			else
+			{
+				Buffer.Reset();
+			}
+		}
+
+		/// <summary>
+		/// Return a buffer's allocation to the pool, Buffer is empty afterwards.
+		/// </summary>
+		void Release(TArray<ElementType>& Buffer)
+		{
+			if (Buffer.Max() == 0)
+			{
+				return;
+			}
+
+			Buffer.Reset();
+			FScopeLock Lock(&BuffersLock);
+			if (Buffers.Num() < MaxBuffers)
+			{
+				Buffers.Add(MoveTemp(Buffer));
+			}
+			else
+			{
+				Buffer.Empty();
+			}
+		}
+
+		void Empty()
+		{
+			FScopeLock Lock(&BuffersLock);
+			Buffers.Empty();
+		}
+
+	private:
+		FCriticalSection BuffersLock;
+		TArray<TArray<ElementType>> Buffers;
+		const int32 MaxBuffers;
+	};
+
+	/// <summary>
+	/// Vertex and index buffers shared by the scans of one scene understanding plugin.
+	/// </summary>
+	struct FMeshBufferPool
+	{
+		// Enough for the meshes of a large room to be recycled from one scan to the next.
+		TBufferPool<FVector> Vertices{1024};
+		TBufferPool<MRMESH_INDEX_TYPE> Indices{1024};
+	};
+}	 // namespace MicrosoftOpenXR
@@ -0,0 +1,188 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "MeshSimplification.h"
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		// Symmetric 4x4 matrix of the plane equations of the triangles merged into a cluster.
+		struct FQuadric
+		{
+			double A00 = 0, A01 = 0, A02 = 0, A03 = 0;
+			double A11 = 0, A12 = 0, A13 = 0;
+			double A22 = 0, A23 = 0;
+
+			void AddPlane(const FVector& Normal, double D, double Weight)
+			{
+				const double X = Normal.X, Y = Normal.Y, Z = Normal.Z;
+				A00 += Weight * X * X;
+				A01 += Weight * X * Y;
+				A02 += Weight * X * Z;
+				A03 += Weight * X * D;
+				A11 += Weight * Y * Y;
+				A12 += Weight * Y * Z;
+				A13 += Weight * Y * D;
+				A22 += Weight * Z * Z;
+				A23 += Weight * Z * D;
+			}
+
+			// Finds the point with the smallest squared distance to all planes, fails when the planes do not pin down a point.
+			bool Solve(FVector& OutPoint) const
+			{
+				const double C00 = A11 * A22 - A12 * A12;
+				const double C01 = A02 * A12 - A01 * A22;
+				const double C02 = A01 * A12 - A02 * A11;
+				const double Det = A00 * C00 + A01 * C01 + A02 * C02;
+				const double Trace = A00 + A11 + A22;
+				if (FMath::Abs(Det) <= 1e-6 * Trace * Trace * Trace)
+				{
+					return false;
+				}
+
+				const double C11 = A00 * A22 - A02 * A02;
+				const double C12 = A01 * A02 - A00 * A12;
+				const double C22 = A00 * A11 - A01 * A01;
+				const double InvDet = 1.0 / Det;
+				OutPoint.X = static_cast<float>(-(C00 * A03 + C01 * A13 + C02 * A23) * InvDet);
+				OutPoint.Y = static_cast<float>(-(C01 * A03 + C11 * A13 + C12 * A23) * InvDet);
+				OutPoint.Z = static_cast<float>(-(C02 * A03 + C12 * A13 + C22 * A23) * InvDet);
+				return true;
+			}
+		};
+
+		struct FCluster
+		{
+			FQuadric Quadric;
+			FVector Sum = FVector::ZeroVector;
+			int32 Count = 0;
+			FIntVector Cell;
+		};
+
+		FIntVector GetCell(const FVector& Position, float InvCellSize)
+		{
+			return FIntVector(FMath::FloorToInt(Position.X * InvCellSize), FMath::FloorToInt(Position.Y * InvCellSize),
+				FMath::FloorToInt(Position.Z * InvCellSize));
+		}
+	}	 // namespace
+
+	void SimplifyMeshByClustering(const TArray<FVector>& Vertices, const TArray<MRMESH_INDEX_TYPE>& Indices, float CellSize,
+		TArray<FVector>& OutVertices, TArray<MRMESH_INDEX_TYPE>& OutIndices)
+	{
+		OutVertices.Reset();
+		OutIndices.Reset();
+		if (CellSize <= 0.0f || Vertices.Num() == 0)
+		{
+			return;
+		}
+
+		const float InvCellSize = 1.0f / CellSize;
+
+		// Assign every vertex to the cluster of its grid cell.
+		TArray<FCluster> Clusters;
+		TArray<int32> VertexToCluster;
+		VertexToCluster.SetNumUninitialized(Vertices.Num());
+		TMap<FIntVector, int32> CellToCluster;
+		CellToCluster.Reserve(Vertices.Num() / 4);
+		for (int32 VertexIndex = 0; VertexIndex < Vertices.Num(); ++VertexIndex)
+		{
+			const FIntVector Cell = GetCell(Vertices[VertexIndex], InvCellSize);
+			int32& ClusterIndex = CellToCluster.FindOrAdd(Cell, INDEX_NONE);
+			if (ClusterIndex == INDEX_NONE)
+			{
+				ClusterIndex = Clusters.AddDefaulted();
+				Clusters[ClusterIndex].Cell = Cell;
+			}
+			FCluster& Cluster = Clusters[ClusterIndex];
+			Cluster.Sum += Vertices[VertexIndex];
+			Cluster.Count++;
+			VertexToCluster[VertexIndex] = ClusterIndex;
+		}
+
+		// Accumulate the area weighted plane of every triangle into the clusters of its corners.
+		const int32 TriangleCount = Indices.Num() / 3;
+		for (int32 Triangle = 0; Triangle < TriangleCount; ++Triangle)
+		{
+			const uint32 I0 = Indices[Triangle * 3];
+			const uint32 I1 = Indices[Triangle * 3 + 1];
+			const uint32 I2 = Indices[Triangle * 3 + 2];
+			if (I0 >= static_cast<uint32>(Vertices.Num()) || I1 >= static_cast<uint32>(Vertices.Num()) ||
+				I2 >= static_cast<uint32>(Vertices.Num()))
+			{
+				continue;
+			}
+
+			const FVector Cross = FVector::CrossProduct(Vertices[I1] - Vertices[I0], Vertices[I2] - Vertices[I0]);
+			const float DoubleArea = Cross.Size();
+			if (DoubleArea <= SMALL_NUMBER)
+			{
+				continue;
+			}
+			const FVector Normal = Cross / DoubleArea;
+			const double D = -FVector::DotProduct(Normal, Vertices[I0]);
+			for (const uint32 Corner : {I0, I1, I2})
+			{
+				Clusters[VertexToCluster[Corner]].Quadric.AddPlane(Normal, D, DoubleArea * 0.5f);
+			}
+		}
+
+		// Place each cluster's vertex at its quadric minimum, unless that falls outside the cell, which happens on flat areas.
+		OutVertices.SetNumUninitialized(Clusters.Num());
+		for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ++ClusterIndex)
+		{
+			const FCluster& Cluster = Clusters[ClusterIndex];
+			const FVector Average = Cluster.Sum / Cluster.Count;
+			const FVector CellMin = FVector(Cluster.Cell) * CellSize;
+			const FBox CellBounds(CellMin, CellMin + FVector(CellSize));
+
+			FVector Position;
+			OutVertices[ClusterIndex] =
+				Cluster.Quadric.Solve(Position) && CellBounds.ExpandBy(CellSize * 0.5f).IsInside(Position) ? Position : Average;
+		}
+
+		// Keep the triangles whose corners are still in three different clusters, once each.
+		TSet<FIntVector> Triangles;
+		Triangles.Reserve(TriangleCount / 2);
+		OutIndices.Reserve(TriangleCount / 2 * 3);
+		for (int32 Triangle = 0; Triangle < TriangleCount; ++Triangle)
+		{
+			const uint32 I0 = Indices[Triangle * 3];
+			const uint32 I1 = Indices[Triangle * 3 + 1];
+			const uint32 I2 = Indices[Triangle * 3 + 2];
+			if (I0 >= static_cast<uint32>(Vertices.Num()) || I1 >= static_cast<uint32>(Vertices.Num()) ||
+				I2 >= static_cast<uint32>(Vertices.Num()))
+			{
+				continue;
+			}
+
+			const int32 C0 = VertexToCluster[I0];
+			const int32 C1 = VertexToCluster[I1];
+			const int32 C2 = VertexToCluster[I2];
+			if (C0 == C1 || C1 == C2 || C0 == C2)
+			{
+				continue;
+			}
+
+			// Rotate the smallest index first so the same triangle has one key, without changing its winding.
+			FIntVector Key(C0, C1, C2);
+			if (C1 < C0 && C1 < C2)
+			{
+				Key = FIntVector(C1, C2, C0);
+			}
+			else if (C2 < C0 && C2 < C1)
+			{
+				Key = FIntVector(C2, C0, C1);
+			}
+
+			bool bAlreadyInSet = false;
+			Triangles.Add(Key, &bAlreadyInSet);
+			if (!bAlreadyInSet)
+			{
+				OutIndices.Add(static_cast<MRMESH_INDEX_TYPE>(Key.X));
+				OutIndices.Add(static_cast<MRMESH_INDEX_TYPE>(Key.Y));
+				OutIndices.Add(static_cast<MRMESH_INDEX_TYPE>(Key.Z));
+			}
+		}
+	}
+}	 // namespace MicrosoftOpenXR
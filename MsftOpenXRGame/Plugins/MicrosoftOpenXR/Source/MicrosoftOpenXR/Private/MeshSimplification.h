@@ -0,0 +1,23 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "OpenXRCommon.h"
+#include "IOpenXRARTrackedGeometryHolder.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Simplifies a triangle mesh by merging all vertices in each cell of a uniform grid into one vertex.
+	/// The merged vertex is placed where it minimizes the quadric error of the triangles around it, so edges and corners are kept.
+	/// Triangles that collapse to a line or a point are dropped.
+	/// </summary>
+	/// <param name="Vertices">Source vertices</param>
+	/// <param name="Indices">Source triangle list</param>
+	/// <param name="CellSize">Size of a grid cell, in the same units as the vertices</param>
+	/// <param name="OutVertices">Simplified vertices</param>
+	/// <param name="OutIndices">Simplified triangle list</param>
+	void SimplifyMeshByClustering(const TArray<FVector>& Vertices, const TArray<MRMESH_INDEX_TYPE>& Indices, float CellSize,
+		TArray<FVector>& OutVertices, TArray<MRMESH_INDEX_TYPE>& OutIndices);
+}	 // namespace MicrosoftOpenXR
@@ -5,6 +5,7 @@
 
 #include "AzureObjectAnchorsPlugin.h"
 #include "CoreMinimal.h"
+#include "DeferredHandleDestroyer.h"
 #include "HandMeshPlugin.h"
 #include "HolographicRemotingPlugin.h"
 #include "HolographicWindowAttachmentPlugin.h"
@@ -18,6 +19,7 @@
 #include "SpatialAnchorPlugin.h"
 #include "SpatialMappingPlugin.h"
 #include "SpeechPlugin.h"
+#include "XRTrackingSystemBase.h"
 
 DEFINE_LOG_CATEGORY(LogAOA)
 
@@ -32,6 +34,8 @@ namespace MicrosoftOpenXR
 	public:
 		void StartupModule() override
 		{
+			FDeferredHandleDestroyer::Startup();
+
 			SpatialAnchorPlugin.Register();
 			HandMeshPlugin.Register();
 			SecondaryViewConfigurationPlugin.Register();
@@ -84,6 +88,9 @@ namespace MicrosoftOpenXR
 #if PLATFORM_HOLOLENS
 			HolographicWindowAttachmentPlugin.Unregister();
 #endif
+
+			// Handles the plugins queued for destruction are destroyed before the module goes away.
+			FDeferredHandleDestroyer::Shutdown();
 		}
 
 		FSecondaryViewConfigurationPlugin SecondaryViewConfigurationPlugin;
@@ -115,6 +122,27 @@ bool UMicrosoftOpenXRFunctionLibrary::SetUseHandMesh(EHandMeshStatus Mode)
 	return MicrosoftOpenXR::g_MicrosoftOpenXRModule->HandMeshPlugin.Turn(Mode);
 }
 
+void UMicrosoftOpenXRFunctionLibrary::UpdateLateLatchedHandMeshVertexBuffer_RenderThread(
+	FRHICommandListImmediate& RHICmdList, EControllerHand Hand, FRHIVertexBuffer* VertexBuffer)
+{
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->HandMeshPlugin.UpdateLateLatchedVertexBuffer_RenderThread(RHICmdList, Hand, VertexBuffer);
+}
+
+bool UMicrosoftOpenXRFunctionLibrary::GetPackedHandMeshData(EControllerHand Hand, FPackedHandMeshData& InOutMesh)
+{
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return false;
+	}
+
+	return MicrosoftOpenXR::g_MicrosoftOpenXRModule->HandMeshPlugin.GetPackedHandMeshData(Hand, InOutMesh);
+}
+
 bool UMicrosoftOpenXRFunctionLibrary::IsQREnabled()
 {
 #if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
@@ -226,6 +254,123 @@ bool UMicrosoftOpenXRFunctionLibrary::CanDetectPlanes()
 	return false;
 }
 
+TArray<FTrackedGeometryTraceResult> UMicrosoftOpenXRFunctionLibrary::LineTraceTrackedObjectsBatched(
+	const TArray<FTrackedGeometryTraceSegment>& Segments, bool bTestPlaneExtents, bool bMultithreaded)
+{
+	TArray<FTrackedGeometryTraceResult> Results;
+	Results.SetNum(Segments.Num());
+
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr || GEngine->XRSystem == nullptr || Segments.Num() == 0)
+	{
+		return Results;
+	}
+
+	TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe> ARSystem =
+		StaticCastSharedPtr<FXRTrackingSystemBase>(GEngine->XRSystem)->GetARCompositionComponent();
+
+	// Each plugin only replaces a result with a closer hit, so the closest hit across both wins.
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.LineTraceTrackedObjects(
+		ARSystem, Segments, bTestPlaneExtents, bMultithreaded, Results);
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.LineTraceTrackedObjects(
+		ARSystem, Segments, bTestPlaneExtents, bMultithreaded, Results);
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+
+	return Results;
+}
+
+void UMicrosoftOpenXRFunctionLibrary::SetSceneScanMode(ESceneScanMode Mode, float IntervalSeconds, float MovementThreshold)
+{
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.SetScanMode(Mode, IntervalSeconds, MovementThreshold);
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.SetScanMode(Mode, IntervalSeconds, MovementThreshold);
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+}
+
+void UMicrosoftOpenXRFunctionLibrary::RequestSceneScan()
+{
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.RequestScan();
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.RequestScan();
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+}
+
+void UMicrosoftOpenXRFunctionLibrary::AddSceneScanSphereBound(FVector Center, float Radius)
+{
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.AddSphereBound(Center, Radius);
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.AddSphereBound(Center, Radius);
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+}
+
+void UMicrosoftOpenXRFunctionLibrary::AddSceneScanBoxBound(FTransform Transform, FVector Extent)
+{
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.AddBoxBound(Transform, Extent);
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.AddBoxBound(Transform, Extent);
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+}
+
+void UMicrosoftOpenXRFunctionLibrary::AddSceneScanFrustumBound(FTransform Transform, float HorizontalFOV, float VerticalFOV, float FarDistance)
+{
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.AddFrustumBound(Transform, HorizontalFOV, VerticalFOV, FarDistance);
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.AddFrustumBound(Transform, HorizontalFOV, VerticalFOV, FarDistance);
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+}
+
+void UMicrosoftOpenXRFunctionLibrary::ClearSceneScanBounds()
+{
+#if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+	if (MicrosoftOpenXR::g_MicrosoftOpenXRModule == nullptr)
+	{
+		return;
+	}
+
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SpatialMappingPlugin.ClearBounds();
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+	MicrosoftOpenXR::g_MicrosoftOpenXRModule->SceneUnderstandingPlugin.ClearBounds();
+#endif	  // !UE_VERSION_OLDER_THAN(4, 27, 1)
+#endif	  // PLATFORM_WINDOWS || PLATFORM_HOLOLENS
+}
+
 bool UMicrosoftOpenXRFunctionLibrary::ToggleAzureObjectAnchors(const bool bOnOff)
 {
 #if PLATFORM_WINDOWS || PLATFORM_HOLOLENS
@@ -0,0 +1,254 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "SceneCache.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		constexpr uint32 SceneCacheMagic = 0x4353534D;	  // "MSSC"
+		constexpr uint32 SceneCacheVersion = 1;
+		// Records and mesh buffers start on this alignment, so a mapped file can be read in place.
+		constexpr int32 SceneCacheAlignment = 16;
+
+		struct FSceneCacheHeader
+		{
+			uint32 Magic;
+			uint32 Version;
+			uint32 ComponentCount;
+			uint32 IndexSize;
+			float WorldToMetersScale;
+			uint32 Reserved;
+			// Offset of the mesh buffers from the start of the file, and their total size.
+			uint64 DataOffset;
+			uint64 DataSize;
+		};
+		static_assert(sizeof(FSceneCacheHeader) == 40, "The scene cache header layout is part of the file format.");
+
+		struct FSceneCacheRecord
+		{
+			uint8 Uuid[16];
+			uint32 MeshGuid[4];
+			float Orientation[4];
+			float Position[3];
+			float Extent[3];
+			uint32 Type;
+			uint32 Reserved;
+			uint64 PlaneHash;
+			uint64 MeshHash;
+			// Offset of the component's vertex buffer from DataOffset, its index buffer follows.
+			uint64 MeshOffset;
+			uint32 VertexCount;
+			uint32 IndexCount;
+			// Stored sizes of the buffers, equal to the uncompressed size when compression did not make them smaller.
+			uint32 VertexDataSize;
+			uint32 IndexDataSize;
+		};
+		static_assert(sizeof(FSceneCacheRecord) == 120, "The scene cache record layout is part of the file format.");
+
+		// Appends a buffer to Data, zlib compressed unless that does not make it smaller, and returns the stored size.
+		uint32 AppendBuffer(TArray<uint8>& Data, const void* Buffer, int32 Size)
+		{
+			if (Size == 0)
+			{
+				return 0;
+			}
+
+			const int32 Offset = Data.Num();
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Size);
+			Data.AddUninitialized(CompressedSize);
+			if (!FCompression::CompressMemory(NAME_Zlib, Data.GetData() + Offset, CompressedSize, Buffer, Size) || CompressedSize >= Size)
+			{
+				Data.SetNum(Offset + Size, false);
+				FMemory::Memcpy(Data.GetData() + Offset, Buffer, Size);
+				return Size;
+			}
+
+			Data.SetNum(Offset + CompressedSize, false);
+			return CompressedSize;
+		}
+
+		bool ReadBuffer(const uint8* StoredData, uint32 StoredSize, void* Buffer, int32 Size)
+		{
+			if (StoredSize == static_cast<uint32>(Size))
+			{
+				FMemory::Memcpy(Buffer, StoredData, Size);
+				return true;
+			}
+			return FCompression::UncompressMemory(NAME_Zlib, Buffer, Size, StoredData, StoredSize);
+		}
+
+		void PadToAlignment(TArray<uint8>& Data)
+		{
+			Data.AddZeroed(Align(Data.Num(), SceneCacheAlignment) - Data.Num());
+		}
+
+		bool ParseSceneCache(TArrayView<const uint8> File, FSceneCache& OutCache)
+		{
+			FSceneCacheHeader Header;
+			if (File.Num() < static_cast<int32>(sizeof(Header)))
+			{
+				return false;
+			}
+			FMemory::Memcpy(&Header, File.GetData(), sizeof(Header));
+
+			const uint64 RecordsEnd = sizeof(FSceneCacheHeader) + static_cast<uint64>(Header.ComponentCount) * sizeof(FSceneCacheRecord);
+			if (Header.Magic != SceneCacheMagic || Header.Version != SceneCacheVersion || Header.IndexSize != sizeof(MRMESH_INDEX_TYPE) ||
+				Header.WorldToMetersScale <= 0.0f || Header.DataOffset < RecordsEnd || Header.DataOffset > static_cast<uint64>(File.Num()) ||
+				Header.DataSize > static_cast<uint64>(File.Num()) - Header.DataOffset)
+			{
+				return false;
+			}
+
+			OutCache.WorldToMetersScale = Header.WorldToMetersScale;
+			OutCache.Components.Reset(Header.ComponentCount);
+			const uint8* Data = File.GetData() + Header.DataOffset;
+			for (uint32 Index = 0; Index < Header.ComponentCount; ++Index)
+			{
+				FSceneCacheRecord Record;
+				FMemory::Memcpy(&Record, File.GetData() + sizeof(FSceneCacheHeader) + Index * sizeof(FSceneCacheRecord), sizeof(Record));
+
+				const uint64 MaxCount = MAX_int32 / sizeof(FVector);
+				if (Record.VertexCount > MaxCount || Record.IndexCount > MaxCount || Record.MeshOffset > Header.DataSize ||
+					static_cast<uint64>(Record.VertexDataSize) + Record.IndexDataSize > Header.DataSize - Record.MeshOffset)
+				{
+					return false;
+				}
+
+				FSceneCacheComponent& Component = OutCache.Components.AddDefaulted_GetRef();
+				FMemory::Memcpy(Component.Uuid.bytes, Record.Uuid, sizeof(Record.Uuid));
+				Component.MeshGuid = FGuid(Record.MeshGuid[0], Record.MeshGuid[1], Record.MeshGuid[2], Record.MeshGuid[3]);
+				Component.PoseInAnchorSpace.orientation = {Record.Orientation[0], Record.Orientation[1], Record.Orientation[2], Record.Orientation[3]};
+				Component.PoseInAnchorSpace.position = {Record.Position[0], Record.Position[1], Record.Position[2]};
+				Component.Type = static_cast<EARObjectClassification>(Record.Type);
+				Component.Extent = FVector(Record.Extent[0], Record.Extent[1], Record.Extent[2]);
+				Component.PlaneHash = Record.PlaneHash;
+				Component.MeshHash = Record.MeshHash;
+
+				if (!Component.MeshGuid.IsValid())
+				{
+					continue;
+				}
+
+				TArray<FVector> Vertices;
+				TArray<MRMESH_INDEX_TYPE> Indices;
+				Vertices.SetNumUninitialized(Record.VertexCount);
+				Indices.SetNumUninitialized(Record.IndexCount);
+				const uint8* MeshData = Data + Record.MeshOffset;
+				if (!ReadBuffer(MeshData, Record.VertexDataSize, Vertices.GetData(), Vertices.Num() * Vertices.GetTypeSize()) ||
+					!ReadBuffer(MeshData + Record.VertexDataSize, Record.IndexDataSize, Indices.GetData(), Indices.Num() * Indices.GetTypeSize()))
+				{
+					return false;
+				}
+
+				// Collision reads the vertices through the indices without bounds checks.
+				for (const MRMESH_INDEX_TYPE VertexIndex : Indices)
+				{
+					if (VertexIndex >= Record.VertexCount)
+					{
+						return false;
+					}
+				}
+
+				Component.MeshData = MakeTrackedMeshData(MoveTemp(Vertices), MoveTemp(Indices));
+			}
+			return true;
+		}
+	}	 // namespace
+
+	bool SaveSceneCache(const FString& Path, const FSceneCache& Cache)
+	{
+		TArray<uint8> File;
+		File.AddZeroed(sizeof(FSceneCacheHeader) + Cache.Components.Num() * sizeof(FSceneCacheRecord));
+		PadToAlignment(File);
+		const int32 DataOffset = File.Num();
+
+		for (int32 Index = 0; Index < Cache.Components.Num(); ++Index)
+		{
+			const FSceneCacheComponent& Component = Cache.Components[Index];
+			FSceneCacheRecord Record{};
+			FMemory::Memcpy(Record.Uuid, Component.Uuid.bytes, sizeof(Record.Uuid));
+			Record.MeshGuid[0] = Component.MeshGuid.A;
+			Record.MeshGuid[1] = Component.MeshGuid.B;
+			Record.MeshGuid[2] = Component.MeshGuid.C;
+			Record.MeshGuid[3] = Component.MeshGuid.D;
+			const XrPosef& Pose = Component.PoseInAnchorSpace;
+			FMemory::Memcpy(Record.Orientation, &Pose.orientation, sizeof(Record.Orientation));
+			FMemory::Memcpy(Record.Position, &Pose.position, sizeof(Record.Position));
+			FMemory::Memcpy(Record.Extent, &Component.Extent, sizeof(Record.Extent));
+			Record.Type = static_cast<uint32>(Component.Type);
+			Record.PlaneHash = Component.PlaneHash;
+			Record.MeshHash = Component.MeshHash;
+
+			if (Component.MeshGuid.IsValid() && Component.MeshData.IsValid())
+			{
+				const TArray<FVector>& Vertices = Component.MeshData->GetVertices();
+				const TArray<MRMESH_INDEX_TYPE>& Indices = Component.MeshData->GetIndices();
+				PadToAlignment(File);
+				Record.MeshOffset = File.Num() - DataOffset;
+				Record.VertexCount = Vertices.Num();
+				Record.IndexCount = Indices.Num();
+				Record.VertexDataSize = AppendBuffer(File, Vertices.GetData(), Vertices.Num() * Vertices.GetTypeSize());
+				Record.IndexDataSize = AppendBuffer(File, Indices.GetData(), Indices.Num() * Indices.GetTypeSize());
+			}
+			else
+			{
+				// Without mesh data the component can not be restored with a mesh.
+				Record.MeshGuid[0] = Record.MeshGuid[1] = Record.MeshGuid[2] = Record.MeshGuid[3] = 0;
+				Record.MeshHash = 0;
+			}
+
+			FMemory::Memcpy(File.GetData() + sizeof(FSceneCacheHeader) + Index * sizeof(FSceneCacheRecord), &Record, sizeof(Record));
+		}
+
+		FSceneCacheHeader Header{};
+		Header.Magic = SceneCacheMagic;
+		Header.Version = SceneCacheVersion;
+		Header.ComponentCount = Cache.Components.Num();
+		Header.IndexSize = sizeof(MRMESH_INDEX_TYPE);
+		Header.WorldToMetersScale = Cache.WorldToMetersScale;
+		Header.DataOffset = DataOffset;
+		Header.DataSize = File.Num() - DataOffset;
+		FMemory::Memcpy(File.GetData(), &Header, sizeof(Header));
+
+		// Write next to the cache and swap it in, so a crash while saving leaves the previous cache intact.
+		const FString TempPath = Path + TEXT(".tmp");
+		return FFileHelper::SaveArrayToFile(File, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true);
+	}
+
+	bool LoadSceneCache(const FString& Path, FSceneCache& OutCache)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Path));
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() ? MappedFile->MapRegion() : nullptr);
+
+		TArray<uint8> FileData;
+		TArrayView<const uint8> File;
+		if (MappedRegion.IsValid() && MappedRegion->GetMappedSize() <= MAX_int32)
+		{
+			File = TArrayView<const uint8>(MappedRegion->GetMappedPtr(), static_cast<int32>(MappedRegion->GetMappedSize()));
+		}
+		else if (FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent))
+		{
+			File = FileData;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (!ParseSceneCache(File, OutCache))
+		{
+			OutCache.Components.Reset();
+			return false;
+		}
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "OpenXRCommon.h"
+#include "ARTypes.h"
+#include "TrackedMeshData.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// A scene component as it was last processed, with its pose relative to the spatial anchor the cache is keyed to.
+	/// </summary>
+	struct FSceneCacheComponent
+	{
+		XrUuidMSFT Uuid{};
+		FGuid MeshGuid;
+		XrPosef PoseInAnchorSpace{{0, 0, 0, 1}, {0, 0, 0}};
+		EARObjectClassification Type = EARObjectClassification::NotApplicable;
+		FVector Extent = FVector::ZeroVector;
+		uint64 PlaneHash = 0;
+		uint64 MeshHash = 0;
+		// Mesh in component space, null when the component has no mesh.
+		FTrackedMeshDataPtr MeshData;
+	};
+
+	/// <summary>
+	/// The processed scene of one scene understanding plugin, so the next session can show it before its first scan completes.
+	/// </summary>
+	struct FSceneCache
+	{
+		// Scale the extents and vertices were converted with.
+		float WorldToMetersScale = 100.0f;
+		TArray<FSceneCacheComponent> Components;
+	};
+
+	// Spatial anchors that scene caches are keyed to are persisted with this prefix, so they are not loaded as ARPins.
+	constexpr const ANSICHAR* SceneCacheAnchorPrefix = "MicrosoftOpenXR.SceneCache.";
+
+	inline bool IsSceneCacheAnchorName(const ANSICHAR* Name)
+	{
+		return FCStringAnsi::Strncmp(Name, SceneCacheAnchorPrefix, FCStringAnsi::Strlen(SceneCacheAnchorPrefix)) == 0;
+	}
+
+	/// <summary>
+	/// Write a scene cache to a compact binary file, replacing the file only once it has been fully written.
+	/// The file is a header, a fixed size record per component, then the zlib compressed mesh buffers,
+	/// so a mapped file can be read without parsing.
+	/// </summary>
+	/// <returns>True if the file was written.</returns>
+	bool SaveSceneCache(const FString& Path, const FSceneCache& Cache);
+
+	/// <summary>
+	/// Read a scene cache written by SaveSceneCache, mapping the file when the platform supports it.
+	/// </summary>
+	/// <returns>True if the file exists and is a valid scene cache.</returns>
+	bool LoadSceneCache(const FString& Path, FSceneCache& OutCache);
+}	 // namespace MicrosoftOpenXR
@@ -6,16 +6,29 @@
 #include "SceneUnderstandingBase.h"
 
 #include "ARBlueprintLibrary.h"
+#include "Async/ParallelFor.h"
+#include "DeferredHandleDestroyer.h"
 #include "Engine.h"
+#include "Hash/CityHash.h"
+#include "HAL/IConsoleManager.h"
 #include "IOpenXRARModule.h"
 #include "IOpenXRARTrackedGeometryHolder.h"
 #include "IXRTrackingSystem.h"
+#include "MeshSimplification.h"
 #include "MicrosoftOpenXR.h"
 #include "Misc/EngineVersionComparison.h"
+#include "Misc/Paths.h"
 #include "OpenXRCore.h"
+#include "RenderCore.h"
+#include "SceneCache.h"
 #include "SceneUnderstandingUtility.h"
 #include "TrackedGeometryCollision.h"
+#include "TrackedGeometrySpatialIndex.h"
+#include "TrackedGeometryTrace.h"
 #include "UniqueHandle.h"
+#include "VertexConversion.h"
+
+#include <algorithm>
 
 #if SUPPORTS_REMOTING
 #include "openxr_msft_holographic_remoting.h"
@@ -27,6 +40,62 @@
 
 class IOpenXRARTrackedMeshHolder;
 
+static TAutoConsoleVariable<float> CVarSceneUnderstandingBudgetMs(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.BudgetMs"),
+	1.0f,
+	TEXT("Game thread time in milliseconds spent adding and relocating scene components each frame."));
+
+static TAutoConsoleVariable<float> CVarSceneUnderstandingGameThreadTargetMs(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.GameThreadTargetMs"),
+	15.0f,
+	TEXT("When the previous game thread frame took longer than this, the scene understanding budgets are halved."));
+
+static TAutoConsoleVariable<int32> CVarSceneUnderstandingMaxVerticesPerFrame(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.MaxVerticesPerFrame"),
+	100000,
+	TEXT("Upper limit on the vertices of changed scene components added each frame."));
+
+static TAutoConsoleVariable<int32> CVarSceneUnderstandingMaxLocatesPerFrame(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.MaxLocatesPerFrame"),
+	64,
+	TEXT("Upper limit on the scene components relocated each frame. Stale components near the user and in view are relocated first."));
+
+static TAutoConsoleVariable<int32> CVarSpatialMappingNumMeshLODs(
+	TEXT("xr.MicrosoftOpenXR.SpatialMapping.NumMeshLODs"),
+	0,
+	TEXT("Number of simplified levels generated for each spatial mapping mesh, 0 sends the full resolution mesh only."));
+
+static TAutoConsoleVariable<float> CVarSpatialMappingMeshLODCellSize(
+	TEXT("xr.MicrosoftOpenXR.SpatialMapping.MeshLODCellSize"),
+	0.1f,
+	TEXT("Size in meters of the vertex clusters of the first simplified spatial mapping mesh level, doubled for each further level."));
+
+static TAutoConsoleVariable<float> CVarSpatialMappingMeshLODDistance(
+	TEXT("xr.MicrosoftOpenXR.SpatialMapping.MeshLODDistance"),
+	3.0f,
+	TEXT("Distance in meters from the head covered by each spatial mapping mesh level."));
+
+static TAutoConsoleVariable<int32> CVarSceneUnderstandingSceneCache(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.SceneCache"),
+	1,
+	TEXT("Save the processed scene to disk, keyed to a persisted spatial anchor, and show it at the start of the next session until the first scan completes."));
+
+static TAutoConsoleVariable<float> CVarSceneUnderstandingSceneCacheSaveIntervalSeconds(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.SceneCacheSaveIntervalSeconds"),
+	30.0f,
+	TEXT("Minimum time in seconds between writes of a changed scene to the scene cache."));
+
+static TAutoConsoleVariable<int32> CVarSceneUnderstandingMaxScenesInFlight(
+	TEXT("xr.MicrosoftOpenXR.SceneUnderstanding.MaxScenesInFlight"),
+	2,
+	TEXT("Scenes computed or read ahead of the scene being added to the world. 1 waits for each scene to be read before computing the next."));
+
+DECLARE_CYCLE_STAT(TEXT("Scene Understanding Add Meshes"), STAT_SceneUnderstandingAddMeshes, STATGROUP_MicrosoftOpenXR);
+DECLARE_CYCLE_STAT(TEXT("Scene Understanding Locate"), STAT_SceneUnderstandingLocate, STATGROUP_MicrosoftOpenXR);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scene Understanding Vertex Budget"), STAT_SceneUnderstandingVertexBudget, STATGROUP_MicrosoftOpenXR);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scene Understanding Vertices Added"), STAT_SceneUnderstandingVerticesAdded, STATGROUP_MicrosoftOpenXR);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scene Understanding Locate Budget"), STAT_SceneUnderstandingLocateBudget, STATGROUP_MicrosoftOpenXR);
+
 namespace MicrosoftOpenXR
 {
 	inline FTransform GetPlaneTransform(const XrPosef& Pose, float WorldToMetersScale)
@@ -50,16 +119,112 @@ namespace MicrosoftOpenXR
 		return TrackedGeometryCollision(MoveTemp(Vertices), MoveTemp(Indices));
 	}
 
+	// Roughly the field of view of a HoloLens 2, plus a margin for head motion.
+	static const float InViewCosAngle = FMath::Cos(FMath::DegreesToRadians(45.0f));
+
+	// Weighs a located component by its distance to the head, with components in view weighing four times more.
+	float GetViewWeight(const XrSceneComponentLocationMSFT& Location, const FVector& HeadPosition, const FVector& HeadForward,
+		float WorldToMetersScale)
+	{
+		const FVector ToComponent = ToFVector(Location.pose.position, WorldToMetersScale) - HeadPosition;
+		const float Weight = 1.0f / (1.0f + ToComponent.Size() / WorldToMetersScale);
+		return FVector::DotProduct(ToComponent.GetSafeNormal(), HeadForward) >= InViewCosAngle ? Weight * 4.0f : Weight;
+	}
+
+	void SortComponentsByView(TArray<int32>& InOutIndices, const TArray<XrSceneComponentLocationMSFT>& Locations,
+		const FVector& HeadPosition, const FVector& HeadForward, float WorldToMetersScale, TArray<TPair<float, int32>>& Scratch)
+	{
+		Scratch.Reset(InOutIndices.Num());
+		for (const int32 Index : InOutIndices)
+		{
+			const XrSceneComponentLocationMSFT& Location = Locations[Index];
+			Scratch.Emplace(
+				IsPoseValid(Location.flags) ? GetViewWeight(Location, HeadPosition, HeadForward, WorldToMetersScale) : 0.0f, Index);
+		}
+
+		TPair<float, int32>* Begin = Scratch.GetData();
+		std::stable_sort(
+			Begin, Begin + Scratch.Num(), [](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key > B.Key; });
+		for (int32 Index = 0; Index < InOutIndices.Num(); ++Index)
+		{
+			InOutIndices[Index] = Scratch[Index].Value;
+		}
+	}
+
+	void ConvertSceneBounds(const TArray<FSphere>& Spheres, const TArray<FBoxBound>& Boxes, const TArray<FFrustumBound>& Frustums,
+		const FTransform& WorldToTracking, float WorldToMetersScale, TArray<XrSceneSphereBoundMSFT>& OutSpheres,
+		TArray<XrSceneOrientedBoxBoundMSFT>& OutBoxes, TArray<XrSceneFrustumBoundMSFT>& OutFrustums)
+	{
+		const float TrackingScale = WorldToTracking.GetMaximumAxisScale() / WorldToMetersScale;
+
+		for (const FSphere& Sphere : Spheres)
+		{
+			OutSpheres.Add({ToXrVector(WorldToTracking.TransformPosition(Sphere.Center), WorldToMetersScale), Sphere.W * TrackingScale});
+		}
+		for (const FBoxBound& Box : Boxes)
+		{
+			// OpenXR box extents are edge to edge, along the x, y and z axes that Unreal's Y, Z and X map to.
+			const FVector Size = Box.Extent * Box.Transform.GetScale3D().GetAbs() * 2.0f * TrackingScale;
+			OutBoxes.Add({ToXrPose(Box.Transform * WorldToTracking, WorldToMetersScale), {Size.Y, Size.Z, Size.X}});
+		}
+		for (const FFrustumBound& Frustum : Frustums)
+		{
+			// Unreal's forward axis maps to OpenXR's -z, which frustums look along.
+			const float HalfHorizontal = FMath::DegreesToRadians(Frustum.HorizontalFOV * 0.5f);
+			const float HalfVertical = FMath::DegreesToRadians(Frustum.VerticalFOV * 0.5f);
+			OutFrustums.Add({ToXrPose(Frustum.Transform * WorldToTracking, WorldToMetersScale),
+				{-HalfHorizontal, HalfHorizontal, HalfVertical, -HalfVertical}, Frustum.FarDistance * TrackingScale});
+		}
+	}
+
+	uint64 GetPlaneHash(EARObjectClassification Type, const FVector& Extent)
+	{
+		return CityHash64WithSeed(reinterpret_cast<const char*>(&Extent), sizeof(FVector), static_cast<uint64>(Type) + 1);
+	}
+
+	// The mesh is submitted with its component's classification, so a reclassified component resubmits an unchanged mesh.
+	uint64 GetMeshHash(EARObjectClassification Type, const TArray<FVector>& Vertices, const TArray<MRMESH_INDEX_TYPE>& Indices)
+	{
+		const uint64 VertexHash = CityHash64WithSeed(
+			reinterpret_cast<const char*>(Vertices.GetData()), Vertices.Num() * sizeof(FVector), static_cast<uint64>(Type) + 1);
+		return CityHash64WithSeed(
+			reinterpret_cast<const char*>(Indices.GetData()), Indices.Num() * sizeof(MRMESH_INDEX_TYPE), VertexHash);
+	}
+
+	// Empties the containers of an already processed scan while keeping their allocations.
+	// Mesh buffers go back to the pool as the last references to their mesh data are dropped.
+	void RecycleSceneUpdate(FSceneUpdate& SceneUpdate)
+	{
+		SceneUpdate.Scene.Reset();
+		SceneUpdate.Planes.Reset();
+		SceneUpdate.PlaneUuids.Reset();
+		SceneUpdate.Locations.Reset();
+		SceneUpdate.PlaneCollisionInfo.Reset();
+		SceneUpdate.MeshCollisionInfo.Reset();
+	}
+
 	// This function should be called in a background thread.
 	TSharedPtr<FSceneUpdate> LoadPlanes(const ExtensionDispatchTable& Ext, FSceneHandle Scene,
 		TMap<XrUuidMSFT, FPlaneData>&& PlaneIdToMeshGuid, const TArray<XrScenePlaneAlignmentTypeMSFT>& PlaneAlignmentFilters,
-		float WorldToMetersScale, XrSceneComponentTypeMSFT SceneComponentType)
+		float WorldToMetersScale, XrSceneComponentTypeMSFT SceneComponentType, XrSpace TrackingSpace, XrTime DisplayTime,
+		const FMeshLODSettings& MeshLODSettings, TSharedPtr<FSceneUpdate> RecycledSceneUpdate,
+		const TSharedPtr<FMeshBufferPool, ESPMode::ThreadSafe>& Pool, FSceneObjectTypeCache&& ObjectTypes)
 	{
-		// Get a map of SceneObject UUID to ObjectType.
-		// Planes will determine their object classification by looking for their parent's UUID in this map.
-		const TMap<XrUuidMSFT, XrSceneObjectTypeMSFT> ObjectTypeMap = GetObjectTypeMap(Scene.Handle(), Ext);
+		// Planes will determine their object classification by looking up their parent's UUID in the object types.
+		ObjectTypes.Update(Scene.Handle(), Ext);
 
-		auto SceneUpdate = MakeShared<FSceneUpdate>();
+		// Reuse the containers and buffers of the scan before the previous one, which the game thread no longer uses.
+		TSharedPtr<FSceneUpdate> SceneUpdate = MoveTemp(RecycledSceneUpdate);
+		if (SceneUpdate.IsValid())
+		{
+			RecycleSceneUpdate(*SceneUpdate);
+		}
+		else
+		{
+			SceneUpdate = MakeShared<FSceneUpdate>();
+		}
+		SceneUpdate->MeshLODSettings = MeshLODSettings;
+		SceneUpdate->ObjectTypes = MoveTemp(ObjectTypes);
 		auto& PlaneUpdates = SceneUpdate->Planes;
 		auto& PlaneCollisionInfo = SceneUpdate->PlaneCollisionInfo;
 		auto& MeshCollisionInfo = SceneUpdate->MeshCollisionInfo;
@@ -82,8 +247,17 @@ namespace MicrosoftOpenXR
 		}
 
 		const int32_t Count = SceneComponents.Num();
-		for (int32_t Index = 0; Index < Count; ++Index)
-		{
+
+		// Per-component results, each slot is only written by the task that processes that component.
+		TArray<FPlaneUpdate> ComponentUpdates;
+		ComponentUpdates.SetNum(Count);
+		TArray<TOptional<TrackedGeometryCollision>> ComponentPlaneCollisions;
+		ComponentPlaneCollisions.SetNum(Count);
+		TArray<TOptional<TrackedGeometryCollision>> ComponentMeshCollisions;
+		ComponentMeshCollisions.SetNum(Count);
+
+		// Reading and converting the mesh buffers is independent for every component, so spread it across worker threads.
+		ParallelFor(Count, [&](int32 Index) {
 			uint64_t MeshBufferID = 0;
 			FVector2D PlaneExtents;
 
@@ -104,17 +278,16 @@ namespace MicrosoftOpenXR
 				const XrScenePlaneMSFT& ScenePlane = ScenePlanes[Index];
 				MeshBufferID = ScenePlane.meshBufferId;
 				PlaneExtents = FVector2D(-ScenePlane.size.height, ScenePlane.size.width);
-				ObjectClassification = GetObjectClassification(GetObjectType(ObjectTypeMap, SceneComponent.parentId));
+				ObjectClassification = GetObjectClassification(SceneUpdate->ObjectTypes.GetObjectType(SceneComponent.parentId));
 			}
 
 			const XrUuidMSFT& PlaneUuid = SceneComponent.id;
-			const FGuid PlaneGuid = XrUuidMSFTToFGuid(PlaneUuid);
+			const auto* PrevPlaneData = PlaneIdToMeshGuid.Find(PlaneUuid);
 
 			FGuid MeshGuid{};
 			// If meshBufferId is zero then the plane doesn't have a mesh. Likely because it wasn't requested.
 			if (MeshBufferID != 0)
 			{
-				const auto* PrevPlaneData = PlaneIdToMeshGuid.Find(PlaneUuid);
 				if (PrevPlaneData != nullptr && PrevPlaneData->MeshGuid.IsValid())
 				{	 // Updated plane
 					MeshGuid = PrevPlaneData->MeshGuid;
@@ -124,33 +297,101 @@ namespace MicrosoftOpenXR
 					MeshGuid = FGuid::NewGuid();
 				}
 			}
-			FPlaneUpdate& PlaneUpdate = PlaneUpdates.Add(PlaneUuid);
+			FPlaneUpdate& PlaneUpdate = ComponentUpdates[Index];
 			PlaneUpdate.MeshGuid = MeshGuid;
 			PlaneUpdate.Type = ObjectClassification;
+			PlaneUpdate.UpdateTime = SceneComponent.updateTime;
 
 			if (!FindingVisibleMeshes)
 			{
 				// Visual mesh does not include planes
 				PlaneUpdate.Extent = FVector(PlaneExtents.X, PlaneExtents.Y, 0) * WorldToMetersScale * 0.5f;
-				PlaneCollisionInfo.Add(PlaneGuid, CreatePlaneGeometryCollision(PlaneUpdate.Extent));
+				ComponentPlaneCollisions[Index].Emplace(CreatePlaneGeometryCollision(PlaneUpdate.Extent));
 			}
 
-			if (MeshBufferID != 0)
+			PlaneUpdate.PlaneHash = GetPlaneHash(PlaneUpdate.Type, PlaneUpdate.Extent);
+			PlaneUpdate.bPlaneChanged = PrevPlaneData == nullptr || PrevPlaneData->PlaneHash != PlaneUpdate.PlaneHash;
+
+			if (MeshBufferID != 0 && PrevPlaneData != nullptr && PrevPlaneData->MeshGuid == MeshGuid && PrevPlaneData->MeshHash != 0 &&
+				PrevPlaneData->UpdateTime == SceneComponent.updateTime && PrevPlaneData->Type == PlaneUpdate.Type)
 			{
-				ReadMeshBuffers(Scene.Handle(), Ext, MeshBufferID, PlaneUpdate.Vertices, PlaneUpdate.Indices);
+				// The runtime has not updated the component since the previous scan and it has not been reclassified,
+				// so its mesh is the one already submitted.
+				PlaneUpdate.MeshHash = PrevPlaneData->MeshHash;
+				PlaneUpdate.bMeshChanged = false;
+			}
+			else if (MeshBufferID != 0)
+			{
+				TArray<FVector> Vertices;
+				TArray<MRMESH_INDEX_TYPE> Indices;
+				ReadMeshBuffers(Scene.Handle(), Ext, MeshBufferID, Vertices, Indices, Pool.Get());
+
+				// The vertices were read back in OpenXR coordinates, convert them in place.
+				ConvertXrVectorsToFVectors(
+					reinterpret_cast<const XrVector3f*>(Vertices.GetData()), Vertices.GetData(), Vertices.Num(), WorldToMetersScale);
+
+				PlaneUpdate.MeshHash = GetMeshHash(PlaneUpdate.Type, Vertices, Indices);
+				PlaneUpdate.bMeshChanged = PrevPlaneData == nullptr || PrevPlaneData->MeshGuid != MeshGuid ||
+										   PrevPlaneData->MeshHash != PlaneUpdate.MeshHash;
+				if (PlaneUpdate.bMeshChanged)
+				{
+					// Collision references the same buffers that are later submitted, the mesh is only stored once.
+					PlaneUpdate.MeshData = MakeTrackedMeshData(MoveTemp(Vertices), MoveTemp(Indices), Pool);
+					ComponentMeshCollisions[Index].Emplace(PlaneUpdate.MeshData.ToSharedRef());
 
-				for (FVector& Vertex : PlaneUpdate.Vertices)
+					// Each level clusters the previous one with twice the cell size.
+					float CellSize = MeshLODSettings.CellSize * WorldToMetersScale;
+					for (int32 LODIndex = 0; LODIndex < MeshLODSettings.NumLODs; ++LODIndex, CellSize *= 2.0f)
+					{
+						const FTrackedMeshData& Source = LODIndex > 0 ? *PlaneUpdate.LODs.Last() : *PlaneUpdate.MeshData;
+						TArray<FVector> LODVertices;
+						TArray<MRMESH_INDEX_TYPE> LODIndices;
+						Pool->Vertices.Acquire(LODVertices);
+						Pool->Indices.Acquire(LODIndices);
+						SimplifyMeshByClustering(Source.GetVertices(), Source.GetIndices(), CellSize, LODVertices, LODIndices);
+						if (LODIndices.Num() == 0)
+						{
+							// The mesh is smaller than a cell, keep the coarsest level that still has triangles.
+							Pool->Vertices.Release(LODVertices);
+							Pool->Indices.Release(LODIndices);
+							break;
+						}
+						PlaneUpdate.LODs.Add(MakeTrackedMeshData(MoveTemp(LODVertices), MoveTemp(LODIndices), Pool));
+					}
+				}
+				else
 				{
-					Vertex.Z = -Vertex.Z;
-					Vertex *= WorldToMetersScale;
-					Vertex = FVector(Vertex.Z, Vertex.X, Vertex.Y);
+					// The existing MRMesh section and collision data are still valid, recycle the duplicate buffers.
+					Pool->Vertices.Release(Vertices);
+					Pool->Indices.Release(Indices);
 				}
-				MeshCollisionInfo.Add(MeshGuid, TrackedGeometryCollision(PlaneUpdate.Vertices, PlaneUpdate.Indices));
 			}
-			// The planes and meshes will need to be located on the main thread using the DisplayTime.
+			else
+			{
+				PlaneUpdate.bMeshChanged = false;
+			}
+		});
+
+		PlaneUpdates.Reserve(Count);
+		for (int32_t Index = 0; Index < Count; ++Index)
+		{
+			const XrUuidMSFT& PlaneUuid = SceneComponents[Index].id;
+			FPlaneUpdate& PlaneUpdate = ComponentUpdates[Index];
+			if (ComponentPlaneCollisions[Index].IsSet())
+			{
+				PlaneCollisionInfo.Add(XrUuidMSFTToFGuid(PlaneUuid), MoveTemp(ComponentPlaneCollisions[Index].GetValue()));
+			}
+			if (ComponentMeshCollisions[Index].IsSet())
+			{
+				MeshCollisionInfo.Add(PlaneUpdate.MeshGuid, MoveTemp(ComponentMeshCollisions[Index].GetValue()));
+			}
+			PlaneUpdates.Add(PlaneUuid, MoveTemp(PlaneUpdate));
 		}
 		SceneUpdate->Scene = MoveTemp(Scene);
 		PlaneUpdates.GetKeys(SceneUpdate->PlaneUuids);
+
+		// These locations only order the first locates, the main thread relocates every component before it is shown.
+		LocateObjects(SceneUpdate->Scene.Handle(), Ext, TrackingSpace, DisplayTime, SceneUpdate->PlaneUuids, SceneUpdate->Locations);
 		return SceneUpdate;
 	}
 
@@ -174,7 +415,25 @@ namespace MicrosoftOpenXR
 	{
 		IModularFeatures::Get().UnregisterModularFeature(GetModularFeatureName(), this);
 		
+		DestroySessionHandles();
+	}
+
+	void FSceneUnderstandingBase::DestroySessionHandles()
+	{
 		Stop();
+
+		DestroySceneCacheAnchor();
+		if (SceneCacheAnchorStore != XR_NULL_HANDLE)
+		{
+			XR_ENSURE_MSFT(xrDestroySpatialAnchorStoreConnectionMSFT(SceneCacheAnchorStore));
+			SceneCacheAnchorStore = XR_NULL_HANDLE;
+		}
+		ViewSpace.Reset();
+
+		// Stop joined the scene worker and queued every scene and the observer, which must not outlive the session.
+		// A scene still owned by a worker would not be covered by the flush.
+		check(!SceneUpdateFuture.IsValid() && !ReadySceneUpdate.IsValid());
+		FDeferredHandleDestroyer::Get().Flush();
 	}
 
 	bool FSceneUnderstandingBase::GetRequiredExtensions(TArray<const ANSICHAR*>& OutExtensions)
@@ -183,6 +442,14 @@ namespace MicrosoftOpenXR
 		return true;
 	}
 
+	bool FSceneUnderstandingBase::GetOptionalExtensions(TArray<const ANSICHAR*>& OutExtensions)
+	{
+		// The scene cache is keyed to a persisted spatial anchor.
+		OutExtensions.Add(XR_MSFT_SPATIAL_ANCHOR_EXTENSION_NAME);
+		OutExtensions.Add(XR_MSFT_SPATIAL_ANCHOR_PERSISTENCE_EXTENSION_NAME);
+		return true;
+	}
+
 	bool FSceneUnderstandingBase::OnToggleARCapture(const bool bOnOff)
 	{
 		if (bOnOff)
@@ -210,109 +477,337 @@ namespace MicrosoftOpenXR
 			return;
 		}
 
+		SCOPE_CYCLE_COUNTER(STAT_SceneUnderstandingLocate);
+		const double StartTime = FPlatformTime::Seconds();
 		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
 
-		XrUuidMSFT Uuid = UuidsToLocate[UuidToLocateThisFrame];
-		XrSceneComponentLocationMSFT Location = Locations[UuidToLocateThisFrame];
+		const int32 Budget = LocateBudget.GetUnits(CVarSceneUnderstandingMaxLocatesPerFrame.GetValueOnGameThread());
+		SET_DWORD_STAT(STAT_SceneUnderstandingLocateBudget, Budget);
+		SelectComponentsToLocate(Budget, LocateSlice);
+		LocateComponents(LocateSlice, DisplayTime, TrackingSpace);
+
+		FQuat HeadOrientation;
+		FVector HeadPosition;
+		const bool bHasHeadPose = XRTrackingSystem->GetCurrentPose(IXRTrackingSystem::HMDDeviceId, HeadOrientation, HeadPosition);
 
 		TrackedMeshHolder->StartMeshUpdates();
 
-		for (int i = 0; i < UuidsToLocatePerFrame; i++)
+		for (const int32 Index : LocateSlice)
 		{
+			const XrUuidMSFT& Uuid = UuidsToLocate[Index];
+			const XrSceneComponentLocationMSFT& Location = Locations[Index];
 			const FGuid PlaneGuid = XrUuidMSFTToFGuid(Uuid);
 			FPlaneUpdate& Plane = Planes.FindChecked(Uuid);
 
+			SendPlaneLocation(Uuid, Location, WorldToMetersScale);
+
+			const bool bCanSwitchLOD = Plane.LODs.Num() > 0 && Plane.MeshGuid.IsValid() && IsPoseValid(Location.flags);
+			const int32 MeshLOD =
+				bCanSwitchLOD ? ChooseMeshLOD(Plane, Location, bHasHeadPose, HeadPosition, WorldToMetersScale) : Plane.SubmittedLOD;
+			if (MeshLOD != Plane.SubmittedLOD)
+			{
+				// The mesh crossed into another LOD's range, send that LOD's buffers along with the new location.
+				SubmitMeshLOD(Plane, MeshLOD, ToFTransform(Location.pose, WorldToMetersScale));
+			}
+			else if (const FPlaneData* PlaneData = PreviousPlanes.Find(Uuid); PlaneData != nullptr)
+			{
+				SendMeshLocation(PlaneData->MeshGuid, Location, WorldToMetersScale);
+			}
+
+			UpdateTraceBounds(Uuid, Plane.MeshGuid, Location, WorldToMetersScale);
+		}
+
+		TrackedMeshHolder->EndMeshUpdates();
+
+		LocateBudget.Update(LocateSlice.Num(), FPlatformTime::Seconds() - StartTime);
+
+		// Once every component has been relocated, another pass starts next frame unless a new scan is ready to replace them.
+		if (NumLocatedThisPass >= UuidsToLocate.Num())
+		{
+			ScanState = EScanState::Idle;
+		}
+	}
+
+	void FSceneUnderstandingBase::SendPlaneLocation(
+		const XrUuidMSFT& Uuid, const XrSceneComponentLocationMSFT& Location, float WorldToMetersScale)
+	{
 #if !UE_VERSION_OLDER_THAN(4, 27, 1)
-			auto PlaneUpdate = MakeShared<FOpenXRMeshUpdate>();
+		auto PlaneUpdate = MakeShared<FOpenXRMeshUpdate>();
 #else
-			auto PlaneUpdate = new FOpenXRMeshUpdate();
+		auto PlaneUpdate = new FOpenXRMeshUpdate();
 #endif
-			const FGuid Guid = XrUuidMSFTToFGuid(Uuid);
-			PlaneUpdate->Id = XrUuidMSFTToFGuid(Uuid);
+		PlaneUpdate->Id = XrUuidMSFTToFGuid(Uuid);
 #if !UE_VERSION_OLDER_THAN(4, 27, 1)
-			PlaneUpdate->SpatialMeshUsageFlags = (EARSpatialMeshUsageFlags)((int32)EARSpatialMeshUsageFlags::Visible);
+		PlaneUpdate->SpatialMeshUsageFlags = (EARSpatialMeshUsageFlags)((int32)EARSpatialMeshUsageFlags::Visible);
 #endif
-			if (IsPoseValid(Location.flags))
-			{
-				PlaneUpdate->TrackingState = EARTrackingState::Tracking;
-				PlaneUpdate->LocalToTrackingTransform = GetPlaneTransform(Location.pose, WorldToMetersScale);
-			}
-			else
-			{
-				PlaneUpdate->TrackingState = EARTrackingState::NotTracking;
-				// EARTrackingState::NotTracking should prevent the mesh from rendering. 
-				// However, when ObjectUpdated is called: UARTrackedGeometry::UpdateTrackedGeometry assumes the mesh is being tracked.
-				// This can cause a loss of tracking to place every mesh at the origin.
-				// Workaround this by scaling the mesh to zero - when it is located again the transform will be corrected.
-				PlaneUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
-			}
-			TrackedMeshHolder->ObjectUpdated(MoveTemp(PlaneUpdate));
+		if (IsPoseValid(Location.flags))
+		{
+			PlaneUpdate->TrackingState = EARTrackingState::Tracking;
+			PlaneUpdate->LocalToTrackingTransform = GetPlaneTransform(Location.pose, WorldToMetersScale);
+		}
+		else
+		{
+			PlaneUpdate->TrackingState = EARTrackingState::NotTracking;
+			// EARTrackingState::NotTracking should prevent the mesh from rendering. 
+			// However, when ObjectUpdated is called: UARTrackedGeometry::UpdateTrackedGeometry assumes the mesh is being tracked.
+			// This can cause a loss of tracking to place every mesh at the origin.
+			// Workaround this by scaling the mesh to zero - when it is located again the transform will be corrected.
+			PlaneUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+		}
+		TrackedMeshHolder->ObjectUpdated(MoveTemp(PlaneUpdate));
+	}
 
-			if (const FPlaneData* PlaneData = PreviousPlanes.Find(Uuid); PlaneData != nullptr)
-			{
+	void FSceneUnderstandingBase::SendMeshLocation(
+		const FGuid& MeshGuid, const XrSceneComponentLocationMSFT& Location, float WorldToMetersScale)
+	{
 #if !UE_VERSION_OLDER_THAN(4, 27, 0)
-				auto MeshUpdate = MakeShared<FOpenXRMeshUpdate>();
+		auto MeshUpdate = MakeShared<FOpenXRMeshUpdate>();
 #else
-				auto MeshUpdate = new FOpenXRMeshUpdate();
+		auto MeshUpdate = new FOpenXRMeshUpdate();
 #endif
-				const FGuid& MeshGuid = PlaneData->MeshGuid;
+		MeshUpdate->Id = MeshGuid;
+#if !UE_VERSION_OLDER_THAN(4, 27, 1)
+		MeshUpdate->SpatialMeshUsageFlags =
+			(EARSpatialMeshUsageFlags)((int32)EARSpatialMeshUsageFlags::Visible |
+				(int32)EARSpatialMeshUsageFlags::Collision);
+#endif
+		if (IsPoseValid(Location.flags))
+		{
+			MeshUpdate->TrackingState = EARTrackingState::Tracking;
+			MeshUpdate->LocalToTrackingTransform = ToFTransform(Location.pose, WorldToMetersScale);
+		}
+		else
+		{
+			MeshUpdate->TrackingState = EARTrackingState::NotTracking;
+			// EARTrackingState::NotTracking should prevent the mesh from rendering. 
+			// However, when ObjectUpdated is called: UARTrackedGeometry::UpdateTrackedGeometry assumes the mesh is being tracked.
+			// This can cause a loss of tracking to place every mesh at the origin.
+			// Workaround this by scaling the mesh to zero - when it is located again the transform will be corrected.
+			MeshUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+		}
+
+		TrackedMeshHolder->ObjectUpdated(MoveTemp(MeshUpdate));
+	}
+
+	int32 FSceneUnderstandingBase::FAdaptiveFrameBudget::GetUnits(int32 MaxUnits)
+	{
+		const bool bGameThreadOverTarget =
+			FPlatformTime::ToMilliseconds(GGameThreadTime) > CVarSceneUnderstandingGameThreadTargetMs.GetValueOnGameThread();
+		if (bGameThreadOverTarget)
+		{
+			// Back off quickly when the frame is already late.
+			Units *= 0.5f;
+		}
+		else if (SecondsPerUnit > 0.0)
+		{
+			// Grow toward the measured budget, at most doubling each frame to avoid a spike on a bad estimate.
+			const float BudgetUnits = static_cast<float>(CVarSceneUnderstandingBudgetMs.GetValueOnGameThread() / 1000.0 / SecondsPerUnit);
+			Units = FMath::Min(BudgetUnits, Units * 2.0f);
+		}
+		Units = FMath::Clamp(Units, 1.0f, static_cast<float>(FMath::Max(1, MaxUnits)));
+		return static_cast<int32>(Units);
+	}
+
+	void FSceneUnderstandingBase::FAdaptiveFrameBudget::Update(int32 UnitsDone, double ElapsedSeconds)
+	{
+		if (UnitsDone <= 0)
+		{
+			return;
+		}
+
+		const double Measured = ElapsedSeconds / UnitsDone;
+		SecondsPerUnit = SecondsPerUnit > 0.0 ? FMath::Lerp(SecondsPerUnit, Measured, 0.25) : Measured;
+	}
+
+	int32 FSceneUnderstandingBase::ChooseMeshLOD(const FPlaneUpdate& Plane, const XrSceneComponentLocationMSFT& Location,
+		bool bHasHeadPose, const FVector& HeadPosition, float WorldToMetersScale) const
+	{
+		if (Plane.LODs.Num() == 0 || !bHasHeadPose || !IsPoseValid(Location.flags))
+		{
+			return FMath::Max(Plane.SubmittedLOD, 0);
+		}
+
+		// Measure to the closest point of the mesh bounds, large meshes are often close to the user while their origin is not.
+		const FTransform MeshToTracking = ToFTransform(Location.pose, WorldToMetersScale);
+		const TrackedGeometryCollision* CollisionInfo = MeshCollisionInfo.Find(Plane.MeshGuid);
+		const float DistanceSquared = CollisionInfo != nullptr
+			? CollisionInfo->GetBoundingBox().TransformBy(MeshToTracking).ComputeSquaredDistanceToPoint(HeadPosition)
+			: FVector::DistSquared(MeshToTracking.GetLocation(), HeadPosition);
+		const float LODPosition = FMath::Sqrt(DistanceSquared) / (MeshLODSettings.LODDistance * WorldToMetersScale);
+
+		// Keep the current LOD until the distance is a tenth of a range past it, so meshes on a boundary do not keep switching.
+		if (Plane.SubmittedLOD != INDEX_NONE && LODPosition > Plane.SubmittedLOD - 0.1f && LODPosition < Plane.SubmittedLOD + 1.1f)
+		{
+			return Plane.SubmittedLOD;
+		}
+		return FMath::Clamp(FMath::FloorToInt(LODPosition), 0, Plane.LODs.Num());
+	}
+
+	void FSceneUnderstandingBase::SubmitMeshLOD(FPlaneUpdate& Plane, int32 LOD, const FTransform& LocalToTrackingTransform)
+	{
+		FOpenXRMeshUpdate* MeshUpdate = TrackedMeshHolder->AllocateMeshUpdate(Plane.MeshGuid);
+		MeshUpdate->Type = Plane.Type;
+		MeshUpdate->LocalToTrackingTransform = LocalToTrackingTransform;
+		// The mesh update owns its buffers, so this is the one copy of the shared mesh data.
+		const FTrackedMeshDataPtr MeshData = LOD > 0 ? FTrackedMeshDataPtr(Plane.LODs[LOD - 1]) : Plane.MeshData;
+		if (MeshData.IsValid())
+		{
+			MeshUpdate->Vertices = MeshData->GetVertices();
+			MeshUpdate->Indices = MeshData->GetIndices();
+		}
+		if (Plane.LODs.Num() == 0)
+		{
+			// There is nothing to switch to later, the collision data keeps its own reference.
+			Plane.MeshData.Reset();
+		}
 
-				MeshUpdate->Id = MeshGuid;
 #if !UE_VERSION_OLDER_THAN(4, 27, 1)
-				MeshUpdate->SpatialMeshUsageFlags =
-					(EARSpatialMeshUsageFlags)((int32)EARSpatialMeshUsageFlags::Visible |
-						(int32)EARSpatialMeshUsageFlags::Collision);
+		MeshUpdate->SpatialMeshUsageFlags =
+			(EARSpatialMeshUsageFlags)((int32)EARSpatialMeshUsageFlags::Visible |
+				(int32)EARSpatialMeshUsageFlags::Collision);
 #endif
-				if (IsPoseValid(Location.flags))
-				{
-					MeshUpdate->TrackingState = EARTrackingState::Tracking;
-					MeshUpdate->LocalToTrackingTransform = ToFTransform(Location.pose, WorldToMetersScale);
-				}
-				else
-				{
-					MeshUpdate->TrackingState = EARTrackingState::NotTracking;
-					// EARTrackingState::NotTracking should prevent the mesh from rendering. 
-					// However, when ObjectUpdated is called: UARTrackedGeometry::UpdateTrackedGeometry assumes the mesh is being tracked.
-					// This can cause a loss of tracking to place every mesh at the origin.
-					// Workaround this by scaling the mesh to zero - when it is located again the transform will be corrected.
-					MeshUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
-				}
+		Plane.SubmittedLOD = LOD;
+	}
 
-				TrackedMeshHolder->ObjectUpdated(MoveTemp(MeshUpdate));
+	void FSceneUnderstandingBase::StartLocatePass()
+	{
+		LocatePassStartFrame = GFrameCounter;
+		NumLocatedThisPass = 0;
+	}
+
+	void FSceneUnderstandingBase::SelectComponentsToLocate(int32 Budget, TArray<int32>& OutIndices)
+	{
+		OutIndices.Reset();
+		const int32 Count = UuidsToLocate.Num();
+		if (Count <= Budget)
+		{
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				OutIndices.Add(Index);
 			}
+			return;
+		}
 
-			UuidToLocateThisFrame++;
-			if (UuidToLocateThisFrame >= UuidsToLocate.Num())
+		FQuat HeadOrientation;
+		FVector HeadPosition;
+		const bool bHasHeadPose = XRTrackingSystem->GetCurrentPose(IXRTrackingSystem::HMDDeviceId, HeadOrientation, HeadPosition);
+		const FVector HeadForward = HeadOrientation.GetForwardVector();
+		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+
+		LocatePriorities.Reset(Count);
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			// Staleness makes sure every component is eventually relocated,
+			// while nearby components in view are relocated more often.
+			float Priority = static_cast<float>(GFrameCounter - LocatedFrames[Index]);
+			const XrSceneComponentLocationMSFT& Location = Locations[Index];
+			if (bHasHeadPose && IsPoseValid(Location.flags))
 			{
-				UuidToLocateThisFrame = 0;
-				ScanState = EScanState::Idle;
-				break;
+				Priority *= GetViewWeight(Location, HeadPosition, HeadForward, WorldToMetersScale);
 			}
+			LocatePriorities.Emplace(Priority, Index);
 		}
 
-		TrackedMeshHolder->EndMeshUpdates();
+		TPair<float, int32>* Begin = LocatePriorities.GetData();
+		std::nth_element(Begin, Begin + Budget, Begin + Count,
+			[](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key > B.Key; });
+		for (int32 Index = 0; Index < Budget; ++Index)
+		{
+			OutIndices.Add(LocatePriorities[Index].Value);
+		}
 	}
 
-	void FSceneUnderstandingBase::ProcessSceneUpdate(FSceneUpdate&& SceneUpdate, XrTime DisplayTime, XrSpace TrackingSpace)
+	void FSceneUnderstandingBase::SortChangedPlanesByView()
 	{
-		PlaneCollisionInfo = MoveTemp(SceneUpdate.PlaneCollisionInfo);
-		MeshCollisionInfo = MoveTemp(SceneUpdate.MeshCollisionInfo);
+		FQuat HeadOrientation;
+		FVector HeadPosition;
+		if (ChangedPlaneIndices.Num() < 2 ||
+			!XRTrackingSystem->GetCurrentPose(IXRTrackingSystem::HMDDeviceId, HeadOrientation, HeadPosition))
+		{
+			return;
+		}
+		const FVector HeadForward = HeadOrientation.GetForwardVector();
 		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
-		LocateObjects(SceneUpdate.Scene.Handle(), Ext, TrackingSpace, DisplayTime, SceneUpdate.PlaneUuids, Locations);
+
+		// Locations are from when the scene was read, close enough to order the components that are added first.
+		SortComponentsByView(ChangedPlaneIndices, Locations, HeadPosition, HeadForward, WorldToMetersScale, LocatePriorities);
+	}
+
+	void FSceneUnderstandingBase::LocateComponents(const TArray<int32>& Indices, XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		if (Indices.Num() == 0)
+		{
+			return;
+		}
+
+		LocateSliceUuids.Reset(Indices.Num());
+		for (const int32 Index : Indices)
+		{
+			LocateSliceUuids.Add(UuidsToLocate[Index]);
+		}
+		LocateObjects(LocatingScene.Handle(), Ext, TrackingSpace, DisplayTime, LocateSliceUuids, LocateSliceLocations);
+
+		for (int32 SliceIndex = 0; SliceIndex < Indices.Num(); ++SliceIndex)
+		{
+			const int32 Index = Indices[SliceIndex];
+			Locations[Index] = LocateSliceLocations[SliceIndex];
+			if (LocatedFrames[Index] < LocatePassStartFrame)
+			{
+				NumLocatedThisPass++;
+			}
+			LocatedFrames[Index] = GFrameCounter;
+		}
+	}
+
+	void FSceneUnderstandingBase::ProcessSceneUpdate(FSceneUpdate& SceneUpdate, XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		// Meshes that have not changed since the previous scan keep their existing collision data and LODs.
+		for (auto& Elem : SceneUpdate.Planes)
+		{
+			FPlaneUpdate& Plane = Elem.Value;
+			if (Plane.MeshGuid.IsValid() && !Plane.bMeshChanged)
+			{
+				if (TrackedGeometryCollision* CollisionInfo = MeshCollisionInfo.Find(Plane.MeshGuid))
+				{
+					SceneUpdate.MeshCollisionInfo.Add(Plane.MeshGuid, MoveTemp(*CollisionInfo));
+				}
+				if (FPlaneUpdate* PreviousPlane = Planes.Find(Elem.Key))
+				{
+					Plane.MeshData = MoveTemp(PreviousPlane->MeshData);
+					Plane.LODs = MoveTemp(PreviousPlane->LODs);
+					Plane.SubmittedLOD = PreviousPlane->SubmittedLOD;
+				}
+			}
+		}
+
+		// Swap rather than move, so the previous scan's containers and buffers go back with the update to be recycled.
+		Swap(PlaneCollisionInfo, SceneUpdate.PlaneCollisionInfo);
+		Swap(MeshCollisionInfo, SceneUpdate.MeshCollisionInfo);
 
 		// Remove any meshes that are no longer in the scene.
 		TrackedMeshHolder->StartMeshUpdates();
 		for (const auto& Elem : PreviousPlanes)
 		{
 			const XrUuidMSFT& PlaneUuid = Elem.Key;
-			if (!SceneUpdate.Planes.Contains(PlaneUuid))
+			const FGuid& MeshGuid = Elem.Value.MeshGuid;
+			const FPlaneUpdate* Plane = SceneUpdate.Planes.Find(PlaneUuid);
+			if (Plane == nullptr)
 			{
-				const FGuid& MeshGuid = Elem.Value.MeshGuid;
+				bSceneCacheDirty = true;
 				if (MeshGuid.IsValid())
 				{
 					TrackedMeshHolder->RemoveMesh(MeshGuid);
+					MeshSpatialIndex.Remove(MeshGuid);
 				}
-				TrackedMeshHolder->RemovePlane(XrUuidMSFTToFGuid(PlaneUuid));
+				const FGuid PlaneGuid = XrUuidMSFTToFGuid(PlaneUuid);
+				TrackedMeshHolder->RemovePlane(PlaneGuid);
+				PlaneSpatialIndex.Remove(PlaneGuid);
+			}
+			else if (MeshGuid.IsValid() && Plane->MeshGuid != MeshGuid)
+			{
+				// The component is still in the scene, but no longer has a mesh.
+				TrackedMeshHolder->RemoveMesh(MeshGuid);
+				MeshSpatialIndex.Remove(MeshGuid);
 			}
 		}
 		TrackedMeshHolder->EndMeshUpdates();
@@ -320,15 +815,37 @@ namespace MicrosoftOpenXR
 		PreviousPlanes.Reset();
 		for (const auto& Elem : SceneUpdate.Planes)
 		{
-			PreviousPlanes.Add(Elem.Key, { Elem.Value.MeshGuid });
+			PreviousPlanes.Add(Elem.Key, { Elem.Value.MeshGuid, Elem.Value.PlaneHash, Elem.Value.MeshHash, Elem.Value.UpdateTime, Elem.Value.Type });
 		}
 
 		// Destroying a Scene is unexpectedly slow so destroy it on a background thread.
-		AsyncTask(ENamedThreads::AnyThread, [Scene = std::move(LocatingScene), Ext = Ext]() mutable { Scene.Reset(); });
+		FDeferredHandleDestroyer::Get().Destroy(MoveTemp(LocatingScene), GET_STATID(STAT_DestroyScene));
 
 		LocatingScene = MoveTemp(SceneUpdate.Scene);
-		UuidsToLocate = MoveTemp(SceneUpdate.PlaneUuids);
-		Planes = MoveTemp(SceneUpdate.Planes);
+		Swap(UuidsToLocate, SceneUpdate.PlaneUuids);
+		Swap(Locations, SceneUpdate.Locations);
+		Swap(Planes, SceneUpdate.Planes);
+		MeshLODSettings = SceneUpdate.MeshLODSettings;
+		Swap(ObjectTypeCache, SceneUpdate.ObjectTypes);
+		// The scan has located its own components, cached ones it did not find have just been removed.
+		CachedComponents.Reset();
+
+		// Components are relocated a slice at a time, starting with the changed components as they are added.
+		LocatedFrames.Init(0, UuidsToLocate.Num());
+		StartLocatePass();
+
+		// Only added and changed components need to be sent to the tracked mesh holder, the rest are only relocated.
+		ChangedPlaneIndices.Reset();
+		for (int32 Index = 0; Index < UuidsToLocate.Num(); ++Index)
+		{
+			const FPlaneUpdate& Plane = Planes.FindChecked(UuidsToLocate[Index]);
+			if (Plane.bPlaneChanged || Plane.bMeshChanged)
+			{
+				ChangedPlaneIndices.Add(Index);
+			}
+		}
+		SortChangedPlanesByView();
+		bSceneCacheDirty |= ChangedPlaneIndices.Num() > 0;
 	}
 
 	void FSceneUnderstandingBase::OnStartARSession(class UARSessionConfig* SessionConfig)
@@ -362,54 +879,117 @@ namespace MicrosoftOpenXR
 		bARSessionStarted = true;
 	}
 
-	TArray<FARTraceResult> FSceneUnderstandingBase::OnLineTraceTrackedObjects(
-		const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe> ARCompositionComponent, const FVector Start,
-		const FVector End, const EARLineTraceChannels TraceChannels)
+	void FSceneUnderstandingBase::UpdateTraceBounds(
+		const XrUuidMSFT& PlaneUuid, const FGuid& MeshGuid, const XrSceneComponentLocationMSFT& Location, float WorldToMetersScale)
 	{
-		// Always hittest meshes, but only hittest planes if PlaneUsingExtent is enabled.
-		// This is because some planes may be floating in space, like wall planes through an open door.
-		bool HitTestPlanes = ((int32)TraceChannels & (int32)EARLineTraceChannels::PlaneUsingExtent) != 0;
+		const FGuid PlaneGuid = XrUuidMSFTToFGuid(PlaneUuid);
+		const TrackedGeometryCollision* PlaneCollision = PlaneCollisionInfo.Find(PlaneGuid);
+		const TrackedGeometryCollision* MeshCollision = MeshGuid.IsValid() ? MeshCollisionInfo.Find(MeshGuid) : nullptr;
+
+		// Components without a location are scaled to zero and can not be hit.
+		if (PlaneCollision != nullptr && IsPoseValid(Location.flags))
+		{
+			PlaneSpatialIndex.Update(
+				PlaneGuid, PlaneCollision->GetBoundingBox().TransformBy(GetPlaneTransform(Location.pose, WorldToMetersScale)));
+		}
+		else
+		{
+			PlaneSpatialIndex.Remove(PlaneGuid);
+		}
+
+		if (MeshCollision != nullptr && IsPoseValid(Location.flags))
+		{
+			MeshSpatialIndex.Update(MeshGuid, MeshCollision->GetBoundingBox().TransformBy(ToFTransform(Location.pose, WorldToMetersScale)));
+		}
+		else if (MeshGuid.IsValid())
+		{
+			MeshSpatialIndex.Remove(MeshGuid);
+		}
+	}
 
-		TArray<FARTraceResult> Results;
-		TArray<UARMeshGeometry*> Meshes = UARBlueprintLibrary::GetAllGeometriesByClass<UARMeshGeometry>();
-		for (UARMeshGeometry* Mesh : Meshes)
+	UARTrackedGeometry* FSceneUnderstandingBase::FindTrackedGeometry(const FGuid& Id, bool& bInOutRefreshed)
+	{
+		if (const TWeakObjectPtr<UARTrackedGeometry>* Geometry = TrackedGeometries.Find(Id))
 		{
-			auto CollisionInfo = MeshCollisionInfo.Find(Mesh->UniqueId);
-			if (CollisionInfo != nullptr)
+			if (UARTrackedGeometry* TrackedGeometry = Geometry->Get())
 			{
-				FVector HitPoint, HitNormal;
-				float HitDistance;
-				if (CollisionInfo->Collides(Start, End, Mesh->GetLocalToWorldTransform(), HitPoint, HitNormal, HitDistance))
-				{
-					// Append a hit.  The calling function will then sort by HitDistance.
-					Results.Add(FARTraceResult(ARCompositionComponent, HitDistance, TraceChannels,
-						FTransform(HitNormal.ToOrientationQuat(), HitPoint), Mesh));
-				}
+				return TrackedGeometry;
 			}
 		}
 
-		if (HitTestPlanes)
+		// Geometry is created by the tracked mesh holder some time after it is submitted, so refresh the lookup at most once per trace.
+		if (bInOutRefreshed)
+		{
+			return nullptr;
+		}
+		bInOutRefreshed = true;
+
+		TrackedGeometries.Reset();
+		for (UARTrackedGeometry* TrackedGeometry : UARBlueprintLibrary::GetAllGeometries())
 		{
-			TArray<UARPlaneGeometry*> TrackedPlanes = UARBlueprintLibrary::GetAllGeometriesByClass<UARPlaneGeometry>();
-			for (UARPlaneGeometry* Plane : TrackedPlanes)
+			if (TrackedGeometry != nullptr)
 			{
-				auto CollisionInfo = PlaneCollisionInfo.Find(Plane->UniqueId);
-				if (CollisionInfo != nullptr)
-				{
-					FVector HitPoint, HitNormal;
-					float HitDistance;
-					if (CollisionInfo->Collides(Start, End, Plane->GetLocalToWorldTransform(), HitPoint, HitNormal, HitDistance))
-					{
-						// Append a hit.  The calling function will then sort by HitDistance.
-						Results.Add(FARTraceResult(ARCompositionComponent, HitDistance, TraceChannels,
-							FTransform(HitNormal.ToOrientationQuat(), HitPoint), Plane));
-					}
-				}
+				TrackedGeometries.Add(TrackedGeometry->UniqueId, TrackedGeometry);
 			}
 		}
-		return Results;
+
+		const TWeakObjectPtr<UARTrackedGeometry>* Geometry = TrackedGeometries.Find(Id);
+		return Geometry != nullptr ? Geometry->Get() : nullptr;
+	}
+
+	TArray<FARTraceResult> FSceneUnderstandingBase::OnLineTraceTrackedObjects(
+		const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe> ARCompositionComponent, const FVector Start,
+		const FVector End, const EARLineTraceChannels TraceChannels)
+	{
+		if (XRTrackingSystem == nullptr)
+		{
+			return {};
+		}
+
+		bool bRefreshedGeometries = false;
+		return LineTraceTrackedGeometry(GetTraceScene(),
+			[this, &bRefreshedGeometries](const FGuid& Id, FTransform& OutLocalToWorld) {
+				return FindTraceGeometry(Id, bRefreshedGeometries, OutLocalToWorld);
+			},
+			ARCompositionComponent, Start, End, TraceChannels);
 	};
 
+	void FSceneUnderstandingBase::LineTraceTrackedObjects(const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe> ARCompositionComponent,
+		TArrayView<const FTrackedGeometryTraceSegment> Segments, bool bTracePlanes, bool bMultithreaded,
+		TArrayView<FTrackedGeometryTraceResult> InOutResults)
+	{
+		check(IsInGameThread());
+
+		if (XRTrackingSystem == nullptr)
+		{
+			return;
+		}
+
+		bool bRefreshedGeometries = false;
+		LineTraceTrackedGeometry(GetTraceScene(),
+			[this, &bRefreshedGeometries](const FGuid& Id, FTransform& OutLocalToWorld) {
+				return FindTraceGeometry(Id, bRefreshedGeometries, OutLocalToWorld);
+			},
+			ARCompositionComponent, Segments, bTracePlanes, bMultithreaded, InOutResults);
+	}
+
+	FTrackedGeometryTraceScene FSceneUnderstandingBase::GetTraceScene() const
+	{
+		// The spatial indices are in tracking space, where the scene components are located.
+		return FTrackedGeometryTraceScene{MeshCollisionInfo, PlaneCollisionInfo, MeshSpatialIndex, PlaneSpatialIndex,
+			UARBlueprintLibrary::GetAlignmentTransform() * XRTrackingSystem->GetTrackingToWorldTransform()};
+	}
+
+	UARTrackedGeometry* FSceneUnderstandingBase::FindTraceGeometry(const FGuid& Id, bool& bInOutRefreshed, FTransform& OutLocalToWorld)
+	{
+		UARTrackedGeometry* Geometry = FindTrackedGeometry(Id, bInOutRefreshed);
+		if (Geometry != nullptr)
+		{
+			OutLocalToWorld = Geometry->GetLocalToWorldTransform();
+		}
+		return Geometry;
+	}
+
 	const void* FSceneUnderstandingBase::OnCreateSession(XrInstance InInstance, XrSystemId InSystem, const void* InNext)
 	{
 		XR_ENSURE(xrGetInstanceProcAddr(
@@ -430,6 +1010,23 @@ namespace MicrosoftOpenXR
 		XR_ENSURE(xrGetInstanceProcAddr(
 			InInstance, "xrGetSceneMeshBuffersMSFT", (PFN_xrVoidFunction*)&Ext.xrGetSceneMeshBuffersMSFT));
 
+		bCanCacheScenes = IOpenXRHMDPlugin::Get().IsExtensionEnabled(XR_MSFT_SPATIAL_ANCHOR_EXTENSION_NAME) &&
+						  IOpenXRHMDPlugin::Get().IsExtensionEnabled(XR_MSFT_SPATIAL_ANCHOR_PERSISTENCE_EXTENSION_NAME);
+		if (bCanCacheScenes)
+		{
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrCreateSpatialAnchorMSFT", (PFN_xrVoidFunction*)&xrCreateSpatialAnchorMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrCreateSpatialAnchorSpaceMSFT", (PFN_xrVoidFunction*)&xrCreateSpatialAnchorSpaceMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrDestroySpatialAnchorMSFT", (PFN_xrVoidFunction*)&xrDestroySpatialAnchorMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(
+				InInstance, "xrCreateSpatialAnchorStoreConnectionMSFT", (PFN_xrVoidFunction*)&xrCreateSpatialAnchorStoreConnectionMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(
+				InInstance, "xrDestroySpatialAnchorStoreConnectionMSFT", (PFN_xrVoidFunction*)&xrDestroySpatialAnchorStoreConnectionMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrPersistSpatialAnchorMSFT", (PFN_xrVoidFunction*)&xrPersistSpatialAnchorMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(InInstance, "xrUnpersistSpatialAnchorMSFT", (PFN_xrVoidFunction*)&xrUnpersistSpatialAnchorMSFT));
+			XR_ENSURE_MSFT(xrGetInstanceProcAddr(
+				InInstance, "xrCreateSpatialAnchorFromPersistedNameMSFT", (PFN_xrVoidFunction*)&xrCreateSpatialAnchorFromPersistedNameMSFT));
+		}
+
 		// Check if Scene Understanding supports plane finding.
 		if (UMicrosoftOpenXRFunctionLibrary::IsRemoting())
 		{
@@ -458,9 +1055,14 @@ namespace MicrosoftOpenXR
 		return bCanDetectPlanes;
 	}
 
-	const void* FSceneUnderstandingBase::OnBeginSession(XrSession InSession, const void* InNext)
+	void FSceneUnderstandingBase::OnDestroySession(XrSession InSession)
 	{
-		static FName SystemName(TEXT("OpenXR"));
+		DestroySessionHandles();
+	}
+
+	const void* FSceneUnderstandingBase::OnBeginSession(XrSession InSession, const void* InNext)
+	{
+		static FName SystemName(TEXT("OpenXR"));
 		if (!GEngine->XRSystem.IsValid() || (GEngine->XRSystem->GetSystemName() != SystemName))
 		{
 			return InNext;
@@ -472,6 +1074,15 @@ namespace MicrosoftOpenXR
 			TrackedMeshHolder = IOpenXRARModule::Get().GetTrackedMeshHolder();
 		}
 		ViewSpace = CreateViewSpace(InSession);
+
+		// Two meter cells keep most scene components in a handful of cells.
+		const float CellSize = 2.0f * XRTrackingSystem->GetWorldToMetersScale();
+		MeshSpatialIndex.Reset(CellSize);
+		PlaneSpatialIndex.Reset(CellSize);
+		TrackedGeometries.Reset();
+
+		Session = InSession;
+		StartLoadingSceneCache();
 		return InNext;
 	}
 
@@ -486,62 +1097,42 @@ namespace MicrosoftOpenXR
 			return;
 		}
 
-		if (ScanState == EScanState::Idle)
+		ApplySceneCache(DisplayTime, TrackingSpace);
+		UpdateCachedComponentLocations(DisplayTime, TrackingSpace);
+
+		UpdateSceneCompute(DisplayTime, TrackingSpace);
+
+		if (SceneUpdateFuture.IsValid() && SceneUpdateFuture.IsReady())
 		{
-			if (bShouldStartSceneUnderstanding)
-			{
-				ComputeNewScene(DisplayTime);
-				ScanState = EScanState::Waiting;
-			}
-			else
-			{
-				// Scene Understanding has been stopped, only locate any existing meshes.
-				if (UuidsToLocate.Num() != 0 && LocatingScene.Handle() != XR_NULL_HANDLE)
-				{
-					LocateObjects(LocatingScene.Handle(), Ext, TrackingSpace, DisplayTime, UuidsToLocate, Locations);
-					ScanState = EScanState::Locating;
-				}
-			}
+			ReadySceneUpdate = SceneUpdateFuture.Get();
+			SceneUpdateFuture.Reset();
 		}
-		else if (ScanState == EScanState::Waiting)
+
+		// A scan replaces the previous one once all of its changes have been added, relocating can restart with the new scene.
+		if (ReadySceneUpdate.IsValid() && ScanState != EScanState::AddMeshesToScene)
 		{
-			XrSceneComputeStateMSFT SceneComputeState;
-			XR_ENSURE(Ext.xrGetSceneComputeStateMSFT(SceneObserver.Handle(), &SceneComputeState));
-			if (SceneComputeState == XR_SCENE_COMPUTE_STATE_COMPLETED_WITH_ERROR_MSFT ||
-				SceneComputeState == XR_SCENE_COMPUTE_STATE_NONE_MSFT)
-			{
-				ScanState = EScanState::Idle;
-			}
-			else if (SceneComputeState == XR_SCENE_COMPUTE_STATE_COMPLETED_MSFT)
-			{
-				XrSceneComponentTypeMSFT SceneComponentType = 
-					GetSceneComputeConsistency() == XR_SCENE_COMPUTE_CONSISTENCY_OCCLUSION_OPTIMIZED_MSFT ?
-					XR_SCENE_COMPONENT_TYPE_VISUAL_MESH_MSFT : XR_SCENE_COMPONENT_TYPE_OBJECT_MSFT;
+			ProcessSceneUpdate(*ReadySceneUpdate, DisplayTime, TrackingSpace);
+			// The update now holds the previous scan's data, the next scan recycles it.
+			RecycledSceneUpdate = MoveTemp(ReadySceneUpdate);
+			ChangedPlaneToAddThisFrame = 0;
+			// Avoid a frame rate dip by adding meshes over multiple frames after processing
+			ScanState = EScanState::AddMeshesToScene;
+		}
 
-				FSceneHandle Scene = CreateScene(Ext, SceneObserver.Handle());
-				TPromise<TSharedPtr<FSceneUpdate>> Promise;
-				SceneUpdateFuture = Promise.GetFuture();
-				AsyncTask(ENamedThreads::AnyThread,
-					[Ext = Ext, WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale(),
-					PlaneAlignmentFilters = PlaneAlignmentFilters, Scene = MoveTemp(Scene),
-					PlaneIdToMeshGuid = PreviousPlanes, Promise = MoveTemp(Promise),
-					SceneComponentType = SceneComponentType]() mutable {
-					Promise.SetValue(LoadPlanes(
-						Ext, MoveTemp(Scene), MoveTemp(PlaneIdToMeshGuid), PlaneAlignmentFilters, 
-						WorldToMetersScale, SceneComponentType));
-				});
-				ScanState = EScanState::Processing;
-			}
+		// The next scene is read against the hashes of the scan just processed.
+		if (!SceneUpdateFuture.IsValid() && !ReadySceneUpdate.IsValid() && ComputedScenes.Num() > 0)
+		{
+			StartReadingScene(DisplayTime, TrackingSpace);
 		}
-		else if (ScanState == EScanState::Processing)
+
+		if (ScanState == EScanState::Idle)
 		{
-			if (SceneUpdateFuture.IsReady())
+			// Keep relocating the existing meshes while the next scan is computed or read, and after scene understanding stops.
+			// Only a scan that is ready to replace them makes another pass pointless.
+			if (!ReadySceneUpdate.IsValid() && UuidsToLocate.Num() != 0 && LocatingScene.Handle() != XR_NULL_HANDLE)
 			{
-				ProcessSceneUpdate(MoveTemp(*SceneUpdateFuture.Get()), DisplayTime, TrackingSpace);
-				SceneUpdateFuture.Reset();
-				UuidToLocateThisFrame = 0;
-				// Avoid a frame rate dip by adding meshes over multiple frames after processing
-				ScanState = EScanState::AddMeshesToScene;
+				StartLocatePass();
+				ScanState = EScanState::Locating;
 			}
 		}
 		else if (ScanState == EScanState::AddMeshesToScene)
@@ -552,99 +1143,646 @@ namespace MicrosoftOpenXR
 				return;
 			}
 
-			const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
-			TrackedMeshHolder->StartMeshUpdates();
-
-			for (int i = 0; i < UuidsToLocatePerFrame; i++)
+			if (ChangedPlaneIndices.Num() == 0)
 			{
-				const XrUuidMSFT& PlaneUuid = UuidsToLocate[UuidToLocateThisFrame];
-				const FGuid PlaneGuid = XrUuidMSFTToFGuid(PlaneUuid);
-				FPlaneUpdate& Plane = Planes.FindChecked(PlaneUuid);
-				const FGuid& MeshGuid = Plane.MeshGuid;
-				const auto& Location = Locations[UuidToLocateThisFrame];
-
-				FOpenXRPlaneUpdate* PlaneUpdate = TrackedMeshHolder->AllocatePlaneUpdate(PlaneGuid);
-				PlaneUpdate->Type = Plane.Type;
-				PlaneUpdate->Extent = Plane.Extent;
-				if (IsPoseValid(Location.flags))
-				{
-					PlaneUpdate->LocalToTrackingTransform = GetPlaneTransform(Location.pose, WorldToMetersScale);
-				}
-				else
+				// Nothing changed since the previous scan, the existing meshes only need to be relocated.
+				ScanState = EScanState::Locating;
+			}
+			else
+			{
+				SCOPE_CYCLE_COUNTER(STAT_SceneUnderstandingAddMeshes);
+				const double StartTime = FPlatformTime::Seconds();
+				const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+
+				// Add components until this frame's vertex budget is spent, always adding at least one.
+				const int32 VertexBudget = AddMeshesBudget.GetUnits(CVarSceneUnderstandingMaxVerticesPerFrame.GetValueOnGameThread());
+				int32 VerticesThisFrame = 0;
+				LocateSlice.Reset();
+				for (int32 ChangedIndex = ChangedPlaneToAddThisFrame;
+					 ChangedIndex < ChangedPlaneIndices.Num() && (LocateSlice.Num() == 0 || VerticesThisFrame < VertexBudget); ++ChangedIndex)
 				{
-					// A location was not found, hide the mesh until it is located.
-					PlaneUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+					const int32 PlaneIndex = ChangedPlaneIndices[ChangedIndex];
+					const FPlaneUpdate& Plane = Planes.FindChecked(UuidsToLocate[PlaneIndex]);
+					// Planes only submit four vertices, count them so plane-only scenes still have a cost.
+					VerticesThisFrame += (Plane.bPlaneChanged ? 4 : 0) + (Plane.bMeshChanged && Plane.MeshData.IsValid() ? Plane.MeshData->GetVertices().Num() : 0);
+					LocateSlice.Add(PlaneIndex);
 				}
+				SET_DWORD_STAT(STAT_SceneUnderstandingVertexBudget, VertexBudget);
+				SET_DWORD_STAT(STAT_SceneUnderstandingVerticesAdded, VerticesThisFrame);
 
-				if (MeshGuid.IsValid())
+				// Locate this frame's components just before they are added.
+				LocateComponents(LocateSlice, DisplayTime, TrackingSpace);
+
+				FQuat HeadOrientation;
+				FVector HeadPosition;
+				const bool bHasHeadPose = XRTrackingSystem->GetCurrentPose(IXRTrackingSystem::HMDDeviceId, HeadOrientation, HeadPosition);
+
+				TrackedMeshHolder->StartMeshUpdates();
+
+				for (const int32 PlaneIndex : LocateSlice)
 				{
-					FOpenXRMeshUpdate* MeshUpdate = TrackedMeshHolder->AllocateMeshUpdate(MeshGuid);
-					MeshUpdate->Type = Plane.Type;
-					MeshUpdate->Vertices = MoveTemp(Plane.Vertices);
-					MeshUpdate->Indices = MoveTemp(Plane.Indices);
-					if (IsPoseValid(Location.flags))
+					const XrUuidMSFT& PlaneUuid = UuidsToLocate[PlaneIndex];
+					const FGuid PlaneGuid = XrUuidMSFTToFGuid(PlaneUuid);
+					FPlaneUpdate& Plane = Planes.FindChecked(PlaneUuid);
+					const FGuid& MeshGuid = Plane.MeshGuid;
+					const auto& Location = Locations[PlaneIndex];
+
+					if (Plane.bPlaneChanged)
 					{
-						MeshUpdate->LocalToTrackingTransform = ToFTransform(Location.pose, WorldToMetersScale);
+						FOpenXRPlaneUpdate* PlaneUpdate = TrackedMeshHolder->AllocatePlaneUpdate(PlaneGuid);
+						PlaneUpdate->Type = Plane.Type;
+						PlaneUpdate->Extent = Plane.Extent;
+						if (IsPoseValid(Location.flags))
+						{
+							PlaneUpdate->LocalToTrackingTransform = GetPlaneTransform(Location.pose, WorldToMetersScale);
+						}
+						else
+						{
+							// A location was not found, hide the mesh until it is located.
+							PlaneUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+						}
 					}
-					else
+
+					if (MeshGuid.IsValid() && Plane.bMeshChanged)
 					{
 						// A location was not found, hide the mesh until it is located.
-						MeshUpdate->LocalToTrackingTransform = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+						const FTransform LocalToTrackingTransform = IsPoseValid(Location.flags)
+							? ToFTransform(Location.pose, WorldToMetersScale)
+							: FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+						SubmitMeshLOD(
+							Plane, ChooseMeshLOD(Plane, Location, bHasHeadPose, HeadPosition, WorldToMetersScale), LocalToTrackingTransform);
 					}
 
-#if !UE_VERSION_OLDER_THAN(4, 27, 1)
-					MeshUpdate->SpatialMeshUsageFlags =
-						(EARSpatialMeshUsageFlags)((int32)EARSpatialMeshUsageFlags::Visible |
-							(int32)EARSpatialMeshUsageFlags::Collision);
-#endif
+					UpdateTraceBounds(PlaneUuid, MeshGuid, Location, WorldToMetersScale);
+
 				}
 
-				UuidToLocateThisFrame++;
-				if (UuidToLocateThisFrame >= UuidsToLocate.Num())
+				TrackedMeshHolder->EndMeshUpdates();
+
+				AddMeshesBudget.Update(FMath::Max(1, VerticesThisFrame), FPlatformTime::Seconds() - StartTime);
+
+				ChangedPlaneToAddThisFrame += LocateSlice.Num();
+				if (ChangedPlaneToAddThisFrame >= ChangedPlaneIndices.Num())
 				{
-					UuidToLocateThisFrame = 0;
+					ChangedPlaneToAddThisFrame = 0;
 					ScanState = EScanState::Locating;
-					break;
 				}
 			}
-
-			TrackedMeshHolder->EndMeshUpdates();
 		}
 
 		UpdateObjectLocations(DisplayTime, TrackingSpace);
+
+		// Write a changed scene to the cache once all of its components have been located.
+		if (bSceneCacheDirty && ScanState == EScanState::Idle && SceneCacheAnchorStore != XR_NULL_HANDLE &&
+			FPlatformTime::Seconds() - LastSceneCacheSaveTime >= CVarSceneUnderstandingSceneCacheSaveIntervalSeconds.GetValueOnGameThread() &&
+			(!SceneCacheSaveFuture.IsValid() || SceneCacheSaveFuture.IsReady()))
+		{
+			WriteSceneCache(DisplayTime, TrackingSpace);
+		}
 	}
 
 	void FSceneUnderstandingBase::Stop()
 	{
 		bShouldStartSceneUnderstanding = false;
 		ScanState = EScanState::Idle;
-		LocatingScene.Reset();
-		SceneObserver.Reset();
+		// Scanning starts again right away when scene understanding restarts, unless scans are only started on request.
+		bScannedSinceStart = false;
+
+		// Drop the scans still in flight.  A scene being read is still used by its worker,
+		// so wait for the worker to hand it back before the scene's observer is queued for destruction.
+		bComputingScene = false;
+		FDeferredHandleDestroyer& Destroyer = FDeferredHandleDestroyer::Get();
+		if (SceneUpdateFuture.IsValid())
+		{
+			SceneUpdateFuture.Wait();
+			TSharedPtr<FSceneUpdate> InFlightSceneUpdate = SceneUpdateFuture.Get();
+			SceneUpdateFuture.Reset();
+			if (InFlightSceneUpdate.IsValid())
+			{
+				Destroyer.Destroy(MoveTemp(InFlightSceneUpdate->Scene), GET_STATID(STAT_DestroyScene));
+			}
+		}
+		if (ReadySceneUpdate.IsValid())
+		{
+			Destroyer.Destroy(MoveTemp(ReadySceneUpdate->Scene), GET_STATID(STAT_DestroyScene));
+			ReadySceneUpdate.Reset();
+		}
+
+		// Handles are destroyed in order, so the scenes go before their observer.
+		for (FSceneHandle& Scene : ComputedScenes)
+		{
+			Destroyer.Destroy(MoveTemp(Scene), GET_STATID(STAT_DestroyScene));
+		}
+		ComputedScenes.Reset();
+		Destroyer.Destroy(MoveTemp(LocatingScene), GET_STATID(STAT_DestroyScene));
+		Destroyer.Destroy(MoveTemp(SceneObserver), GET_STATID(STAT_DestroySceneObserver));
+
+		// Geometry may not have been fully submitted, so send everything again when scene understanding restarts.
+		for (auto& Elem : PreviousPlanes)
+		{
+			Elem.Value.PlaneHash = 0;
+			Elem.Value.MeshHash = 0;
+		}
+	}
+
+	FString FSceneUnderstandingBase::GetSceneCacheName()
+	{
+		return GetSceneComputeConsistency() == XR_SCENE_COMPUTE_CONSISTENCY_OCCLUSION_OPTIMIZED_MSFT ? TEXT("SpatialMapping")
+																									   : TEXT("SceneUnderstanding");
+	}
+
+	FString FSceneUnderstandingBase::GetSceneCachePath()
+	{
+		return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MicrosoftOpenXR"), GetSceneCacheName() + TEXT(".scenecache"));
+	}
+
+	XrSpatialAnchorPersistenceNameMSFT FSceneUnderstandingBase::GetSceneCacheAnchorName()
+	{
+		XrSpatialAnchorPersistenceNameMSFT Name{};
+		const FString AnchorName = FString(SceneCacheAnchorPrefix) + GetSceneCacheName();
+		FCStringAnsi::Strncpy(Name.name, TCHAR_TO_ANSI(*AnchorName), XR_MAX_SPATIAL_ANCHOR_NAME_SIZE_MSFT);
+		return Name;
+	}
+
+	void FSceneUnderstandingBase::StartLoadingSceneCache()
+	{
+		// DestroySessionHandles released the handles of a previous session.
+		SceneCacheAnchorStore = XR_NULL_HANDLE;
+		SceneCacheAnchor = XR_NULL_HANDLE;
+		SceneCacheAnchorSpace = XR_NULL_HANDLE;
+		SceneCacheFuture.Reset();
+		bSceneCacheDirty = false;
+
+		if (!bCanCacheScenes || CVarSceneUnderstandingSceneCache.GetValueOnGameThread() == 0 ||
+			XR_FAILED(xrCreateSpatialAnchorStoreConnectionMSFT(Session, &SceneCacheAnchorStore)))
+		{
+			SceneCacheAnchorStore = XR_NULL_HANDLE;
+			return;
+		}
+
+		// The cached poses are relative to the anchor, so there is nothing to load until a cache has been written with one.
+		XrSpatialAnchorFromPersistedAnchorCreateInfoMSFT CreateInfo{XR_TYPE_SPATIAL_ANCHOR_FROM_PERSISTED_ANCHOR_CREATE_INFO_MSFT};
+		CreateInfo.spatialAnchorStore = SceneCacheAnchorStore;
+		CreateInfo.spatialAnchorPersistenceName = GetSceneCacheAnchorName();
+		XrSpatialAnchorMSFT Anchor = XR_NULL_HANDLE;
+		if (XR_FAILED(xrCreateSpatialAnchorFromPersistedNameMSFT(Session, &CreateInfo, &Anchor)) || !SetSceneCacheAnchor(Anchor))
+		{
+			return;
+		}
+
+		TPromise<TSharedPtr<FSceneCache>> Promise;
+		SceneCacheFuture = Promise.GetFuture();
+		AsyncTask(ENamedThreads::AnyThread, [Path = GetSceneCachePath(), Promise = MoveTemp(Promise)]() mutable {
+			TSharedPtr<FSceneCache> Cache = MakeShared<FSceneCache>();
+			Promise.SetValue(LoadSceneCache(Path, *Cache) ? Cache : nullptr);
+		});
+	}
+
+	void FSceneUnderstandingBase::ApplySceneCache(XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		if (!SceneCacheFuture.IsValid() || !SceneCacheFuture.IsReady())
+		{
+			return;
+		}
+
+		// The cache only fills the gap before the first scan, once a scan is being processed it is out of date.
+		if (PreviousPlanes.Num() > 0 || SceneUpdateFuture.IsValid() || ReadySceneUpdate.IsValid())
+		{
+			SceneCacheFuture.Reset();
+			return;
+		}
+
+		XrSpaceLocation AnchorLocation{XR_TYPE_SPACE_LOCATION};
+		if (XR_FAILED(xrLocateSpace(SceneCacheAnchorSpace, TrackingSpace, DisplayTime, &AnchorLocation)) ||
+			!IsPoseValid(AnchorLocation.locationFlags))
+		{
+			// The anchor has not been found in the current map yet, try again next frame.
+			return;
+		}
+
+		const TSharedPtr<FSceneCache> Cache = SceneCacheFuture.Get();
+		SceneCacheFuture.Reset();
+		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+		if (!Cache.IsValid() || Cache->WorldToMetersScale != WorldToMetersScale)
+		{
+			return;
+		}
+
+		const FTransform AnchorToTracking = ToFTransform(AnchorLocation.pose, WorldToMetersScale);
+		CachedAnchorToTracking = AnchorToTracking;
+		CachedComponents.Reset(Cache->Components.Num());
+		const bool bVisualMeshes = GetSceneComputeConsistency() == XR_SCENE_COMPUTE_CONSISTENCY_OCCLUSION_OPTIMIZED_MSFT;
+
+		// Cached components are added as they were, with the hashes they were scanned with.
+		// The first scan keeps the components it finds unchanged and removes the rest, like any other scan.
+		TrackedMeshHolder->StartMeshUpdates();
+		for (FSceneCacheComponent& Component : Cache->Components)
+		{
+			const FGuid PlaneGuid = XrUuidMSFTToFGuid(Component.Uuid);
+			XrSceneComponentLocationMSFT Location{};
+			Location.flags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT;
+			Location.pose =
+				ToXrPose(ToFTransform(Component.PoseInAnchorSpace, WorldToMetersScale) * AnchorToTracking, WorldToMetersScale);
+
+			FPlaneUpdate& Plane = Planes.Add(Component.Uuid);
+			Plane.MeshGuid = Component.MeshGuid;
+			Plane.Type = Component.Type;
+			Plane.Extent = Component.Extent;
+			Plane.MeshData = MoveTemp(Component.MeshData);
+			Plane.PlaneHash = Component.PlaneHash;
+			Plane.MeshHash = Component.MeshHash;
+			Plane.bPlaneChanged = false;
+			Plane.bMeshChanged = false;
+
+			FOpenXRPlaneUpdate* PlaneUpdate = TrackedMeshHolder->AllocatePlaneUpdate(PlaneGuid);
+			PlaneUpdate->Type = Plane.Type;
+			PlaneUpdate->Extent = Plane.Extent;
+			PlaneUpdate->LocalToTrackingTransform = GetPlaneTransform(Location.pose, WorldToMetersScale);
+			if (!bVisualMeshes)
+			{
+				PlaneCollisionInfo.Add(PlaneGuid, CreatePlaneGeometryCollision(Plane.Extent));
+			}
+
+			if (Plane.MeshGuid.IsValid() && Plane.MeshData.IsValid())
+			{
+				MeshCollisionInfo.Add(Plane.MeshGuid, TrackedGeometryCollision(Plane.MeshData.ToSharedRef()));
+				SubmitMeshLOD(Plane, 0, ToFTransform(Location.pose, WorldToMetersScale));
+			}
+
+			UpdateTraceBounds(Component.Uuid, Plane.MeshGuid, Location, WorldToMetersScale);
+			// No runtime update time is zero, so the first scan reads every cached mesh rather than skipping it as unchanged.
+			PreviousPlanes.Add(Component.Uuid, {Plane.MeshGuid, Plane.PlaneHash, Plane.MeshHash, 0, Plane.Type});
+			CachedComponents.Add({Component.Uuid, Component.PoseInAnchorSpace});
+		}
+		TrackedMeshHolder->EndMeshUpdates();
+	}
+
+	void FSceneUnderstandingBase::UpdateCachedComponentLocations(XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		if (CachedComponents.Num() == 0 || SceneCacheAnchorSpace == XR_NULL_HANDLE)
+		{
+			return;
+		}
+
+		XrSpaceLocation AnchorLocation{XR_TYPE_SPACE_LOCATION};
+		if (XR_FAILED(xrLocateSpace(SceneCacheAnchorSpace, TrackingSpace, DisplayTime, &AnchorLocation)) ||
+			!IsPoseValid(AnchorLocation.locationFlags))
+		{
+			// Keep the last known poses while the anchor is not located.
+			return;
+		}
+
+		// The anchor only moves when the map is refined, skip the updates until it does.
+		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+		const FTransform AnchorToTracking = ToFTransform(AnchorLocation.pose, WorldToMetersScale);
+		if (AnchorToTracking.GetLocation().Equals(CachedAnchorToTracking.GetLocation(), 0.001f * WorldToMetersScale) &&
+			AnchorToTracking.GetRotation().Equals(CachedAnchorToTracking.GetRotation(), 1.e-4f))
+		{
+			return;
+		}
+		CachedAnchorToTracking = AnchorToTracking;
+
+		TrackedMeshHolder->StartMeshUpdates();
+		for (const FCachedComponent& Component : CachedComponents)
+		{
+			const FPlaneUpdate* Plane = Planes.Find(Component.Uuid);
+			if (Plane == nullptr)
+			{
+				continue;
+			}
+
+			XrSceneComponentLocationMSFT Location{};
+			Location.flags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT;
+			Location.pose =
+				ToXrPose(ToFTransform(Component.PoseInAnchorSpace, WorldToMetersScale) * AnchorToTracking, WorldToMetersScale);
+
+			SendPlaneLocation(Component.Uuid, Location, WorldToMetersScale);
+			if (Plane->MeshGuid.IsValid())
+			{
+				SendMeshLocation(Plane->MeshGuid, Location, WorldToMetersScale);
+			}
+			UpdateTraceBounds(Component.Uuid, Plane->MeshGuid, Location, WorldToMetersScale);
+		}
+		TrackedMeshHolder->EndMeshUpdates();
+	}
+
+	void FSceneUnderstandingBase::WriteSceneCache(XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		bSceneCacheDirty = false;
+		LastSceneCacheSaveTime = FPlatformTime::Seconds();
+		if (LocatingScene.Handle() == XR_NULL_HANDLE || UuidsToLocate.Num() == 0 ||
+			(SceneCacheAnchorSpace == XR_NULL_HANDLE && !CreateSceneCacheAnchor(DisplayTime)))
+		{
+			return;
+		}
+
+		// The locate pass that just finished holds every component's tracking space pose, only the anchor needs locating.
+		XrSpaceLocation AnchorLocation{XR_TYPE_SPACE_LOCATION};
+		if (XR_FAILED(xrLocateSpace(SceneCacheAnchorSpace, TrackingSpace, DisplayTime, &AnchorLocation)) ||
+			!IsPoseValid(AnchorLocation.locationFlags))
+		{
+			bSceneCacheDirty = true;
+			return;
+		}
+
+		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+		const FTransform TrackingToAnchor = ToFTransform(AnchorLocation.pose, WorldToMetersScale).Inverse();
+
+		TSharedPtr<FSceneCache> Cache = MakeShared<FSceneCache>();
+		Cache->WorldToMetersScale = WorldToMetersScale;
+		Cache->Components.Reserve(UuidsToLocate.Num());
+		for (int32 Index = 0; Index < UuidsToLocate.Num(); ++Index)
+		{
+			if (!IsPoseValid(Locations[Index].flags))
+			{
+				continue;
+			}
+
+			const FPlaneUpdate& Plane = Planes.FindChecked(UuidsToLocate[Index]);
+			FSceneCacheComponent& Component = Cache->Components.AddDefaulted_GetRef();
+			Component.Uuid = UuidsToLocate[Index];
+			Component.MeshGuid = Plane.MeshGuid;
+			Component.PoseInAnchorSpace =
+				ToXrPose(ToFTransform(Locations[Index].pose, WorldToMetersScale) * TrackingToAnchor, WorldToMetersScale);
+			Component.Type = Plane.Type;
+			Component.Extent = Plane.Extent;
+			Component.PlaneHash = Plane.PlaneHash;
+			Component.MeshHash = Plane.MeshHash;
+			// The collision data holds every submitted mesh, the cache references it rather than copying it.
+			if (const TrackedGeometryCollision* CollisionInfo = Plane.MeshGuid.IsValid() ? MeshCollisionInfo.Find(Plane.MeshGuid) : nullptr)
+			{
+				Component.MeshData = CollisionInfo->GetMeshData();
+			}
+		}
+
+		TPromise<bool> Promise;
+		SceneCacheSaveFuture = Promise.GetFuture();
+		AsyncTask(ENamedThreads::AnyThread, [Path = GetSceneCachePath(), Cache = MoveTemp(Cache), Promise = MoveTemp(Promise)]() mutable {
+			Promise.SetValue(SaveSceneCache(Path, *Cache));
+		});
+	}
+
+	bool FSceneUnderstandingBase::CreateSceneCacheAnchor(XrTime DisplayTime)
+	{
+		if (SceneCacheAnchorStore == XR_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		// Anchors are most accurate close to where they were created, so anchor the cache at the user.
+		XrSpatialAnchorCreateInfoMSFT CreateInfo{XR_TYPE_SPATIAL_ANCHOR_CREATE_INFO_MSFT};
+		CreateInfo.space = ViewSpace.Handle();
+		CreateInfo.pose = ToXrPose(FTransform::Identity);
+		CreateInfo.time = DisplayTime;
+		XrSpatialAnchorMSFT Anchor = XR_NULL_HANDLE;
+		if (XR_FAILED(xrCreateSpatialAnchorMSFT(Session, &CreateInfo, &Anchor)) || !SetSceneCacheAnchor(Anchor))
+		{
+			return false;
+		}
+
+		// Replace the anchor of a cache from an earlier session that could not be loaded.
+		XrSpatialAnchorPersistenceNameMSFT Name = GetSceneCacheAnchorName();
+		xrUnpersistSpatialAnchorMSFT(SceneCacheAnchorStore, &Name);
+
+		XrSpatialAnchorPersistenceInfoMSFT PersistenceInfo{XR_TYPE_SPATIAL_ANCHOR_PERSISTENCE_INFO_MSFT};
+		PersistenceInfo.spatialAnchorPersistenceName = Name;
+		PersistenceInfo.spatialAnchor = SceneCacheAnchor;
+		if (XR_FAILED(xrPersistSpatialAnchorMSFT(SceneCacheAnchorStore, &PersistenceInfo)))
+		{
+			DestroySceneCacheAnchor();
+			return false;
+		}
+		return true;
+	}
+
+	bool FSceneUnderstandingBase::SetSceneCacheAnchor(XrSpatialAnchorMSFT Anchor)
+	{
+		XrSpatialAnchorSpaceCreateInfoMSFT SpaceCreateInfo{XR_TYPE_SPATIAL_ANCHOR_SPACE_CREATE_INFO_MSFT};
+		SpaceCreateInfo.anchor = Anchor;
+		SpaceCreateInfo.poseInAnchorSpace = ToXrPose(FTransform::Identity);
+		XrSpace AnchorSpace = XR_NULL_HANDLE;
+		if (XR_FAILED(xrCreateSpatialAnchorSpaceMSFT(Session, &SpaceCreateInfo, &AnchorSpace)))
+		{
+			xrDestroySpatialAnchorMSFT(Anchor);
+			return false;
+		}
+
+		DestroySceneCacheAnchor();
+		SceneCacheAnchor = Anchor;
+		SceneCacheAnchorSpace = AnchorSpace;
+		return true;
+	}
+
+	void FSceneUnderstandingBase::DestroySceneCacheAnchor()
+	{
+		CachedComponents.Reset();
+		if (SceneCacheAnchorSpace != XR_NULL_HANDLE)
+		{
+			xrDestroySpace(SceneCacheAnchorSpace);
+			SceneCacheAnchorSpace = XR_NULL_HANDLE;
+		}
+		if (SceneCacheAnchor != XR_NULL_HANDLE)
+		{
+			xrDestroySpatialAnchorMSFT(SceneCacheAnchor);
+			SceneCacheAnchor = XR_NULL_HANDLE;
+		}
+	}
+
+	int32 FSceneUnderstandingBase::GetNumScenesInFlight() const
+	{
+		return (bComputingScene ? 1 : 0) + ComputedScenes.Num() + (SceneUpdateFuture.IsValid() ? 1 : 0) + (ReadySceneUpdate.IsValid() ? 1 : 0);
+	}
+
+	void FSceneUnderstandingBase::SetScanMode(ESceneScanMode Mode, float IntervalSeconds, float MovementThreshold)
+	{
+		ScanMode = Mode;
+		ScanIntervalSeconds = FMath::Max(0.0f, IntervalSeconds);
+		ScanMovementThreshold = FMath::Max(0.0f, MovementThreshold);
+	}
+
+	void FSceneUnderstandingBase::RequestScan()
+	{
+		bScanRequested = true;
+	}
+
+	bool FSceneUnderstandingBase::ShouldStartScan()
+	{
+		FQuat HeadOrientation;
+		FVector HeadPosition;
+		const bool bHasHeadPose = XRTrackingSystem->GetCurrentPose(IXRTrackingSystem::HMDDeviceId, HeadOrientation, HeadPosition);
+		const double Now = FPlatformTime::Seconds();
+
+		bool bShouldStart = bScanRequested;
+		switch (ScanMode)
+		{
+		case ESceneScanMode::Continuous:
+			bShouldStart = true;
+			break;
+		case ESceneScanMode::Interval:
+			bShouldStart |= !bScannedSinceStart || Now - LastScanStartTime >= ScanIntervalSeconds;
+			break;
+		case ESceneScanMode::HeadMovement:
+			// Without a head pose there is nothing to measure against, so a scan only starts on request.
+			bShouldStart |= !bScannedSinceStart ||
+				(bHasHeadPose && (!LastScanHeadPosition.IsSet() ||
+									 FVector::DistSquared(HeadPosition, LastScanHeadPosition.GetValue()) >=
+										 FMath::Square(ScanMovementThreshold)));
+			break;
+		case ESceneScanMode::OnDemand:
+			break;
+		}
+
+		if (bShouldStart)
+		{
+			bScanRequested = false;
+			bScannedSinceStart = true;
+			LastScanStartTime = Now;
+			LastScanHeadPosition = bHasHeadPose ? TOptional<FVector>(HeadPosition) : TOptional<FVector>();
+		}
+		return bShouldStart;
+	}
+
+	void FSceneUnderstandingBase::UpdateSceneCompute(XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		if (bComputingScene)
+		{
+			XrSceneComputeStateMSFT SceneComputeState;
+			XR_ENSURE(Ext.xrGetSceneComputeStateMSFT(SceneObserver.Handle(), &SceneComputeState));
+			if (SceneComputeState == XR_SCENE_COMPUTE_STATE_COMPLETED_WITH_ERROR_MSFT ||
+				SceneComputeState == XR_SCENE_COMPUTE_STATE_NONE_MSFT)
+			{
+				bComputingScene = false;
+			}
+			else if (SceneComputeState == XR_SCENE_COMPUTE_STATE_COMPLETED_MSFT)
+			{
+				ComputedScenes.Add(CreateScene(Ext, SceneObserver.Handle()));
+				bComputingScene = false;
+			}
+		}
+
+		// Start the next compute as soon as the observer is free, so computing overlaps with reading and adding earlier scenes.
+		const int32 MaxScenesInFlight = FMath::Max(1, CVarSceneUnderstandingMaxScenesInFlight.GetValueOnGameThread());
+		if (!bComputingScene && bShouldStartSceneUnderstanding && GetNumScenesInFlight() < MaxScenesInFlight && ShouldStartScan())
+		{
+			ComputeNewScene(DisplayTime, TrackingSpace);
+			bComputingScene = true;
+		}
+	}
+
+	void FSceneUnderstandingBase::StartReadingScene(XrTime DisplayTime, XrSpace TrackingSpace)
+	{
+		// Only the newest scene is worth reading, it supersedes any scene computed before it.
+		FSceneHandle Scene = MoveTemp(ComputedScenes.Last());
+		ComputedScenes.Pop(false);
+		for (FSceneHandle& SkippedScene : ComputedScenes)
+		{
+			FDeferredHandleDestroyer::Get().Destroy(MoveTemp(SkippedScene), GET_STATID(STAT_DestroyScene));
+		}
+		ComputedScenes.Reset();
+
+		XrSceneComponentTypeMSFT SceneComponentType = 
+			GetSceneComputeConsistency() == XR_SCENE_COMPUTE_CONSISTENCY_OCCLUSION_OPTIMIZED_MSFT ?
+			XR_SCENE_COMPONENT_TYPE_VISUAL_MESH_MSFT : XR_SCENE_COMPONENT_TYPE_OBJECT_MSFT;
+
+		// Only the visual mesh used by spatial mapping is dense enough to need simplified levels.
+		FMeshLODSettings SceneMeshLODSettings;
+		if (SceneComponentType == XR_SCENE_COMPONENT_TYPE_VISUAL_MESH_MSFT)
+		{
+			SceneMeshLODSettings.NumLODs = FMath::Clamp(CVarSpatialMappingNumMeshLODs.GetValueOnGameThread(), 0, 8);
+			SceneMeshLODSettings.CellSize = FMath::Max(0.01f, CVarSpatialMappingMeshLODCellSize.GetValueOnGameThread());
+			SceneMeshLODSettings.LODDistance = FMath::Max(0.1f, CVarSpatialMappingMeshLODDistance.GetValueOnGameThread());
+		}
+
+		// Vertices are converted with the world to meters scale, so when it changes every mesh has to be read again.
+		const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+		if (WorldToMetersScale != ReadSceneWorldToMetersScale)
+		{
+			for (auto& Elem : PreviousPlanes)
+			{
+				Elem.Value.UpdateTime = 0;
+			}
+			ReadSceneWorldToMetersScale = WorldToMetersScale;
+		}
+
+		TPromise<TSharedPtr<FSceneUpdate>> Promise;
+		SceneUpdateFuture = Promise.GetFuture();
+		AsyncTask(ENamedThreads::AnyThread,
+			[Ext = Ext, WorldToMetersScale,
+			PlaneAlignmentFilters = PlaneAlignmentFilters, Scene = MoveTemp(Scene),
+			PlaneIdToMeshGuid = PreviousPlanes, Promise = MoveTemp(Promise),
+			SceneComponentType = SceneComponentType, TrackingSpace, DisplayTime,
+			MeshLODSettings = SceneMeshLODSettings, RecycledSceneUpdate = MoveTemp(RecycledSceneUpdate),
+			Pool = MeshBufferPool, ObjectTypes = MoveTemp(ObjectTypeCache)]() mutable {
+			Promise.SetValue(LoadPlanes(
+				Ext, MoveTemp(Scene), MoveTemp(PlaneIdToMeshGuid), PlaneAlignmentFilters, 
+				WorldToMetersScale, SceneComponentType, TrackingSpace, DisplayTime, MeshLODSettings,
+				MoveTemp(RecycledSceneUpdate), Pool, MoveTemp(ObjectTypes)));
+		});
+	}
+
+	void FSceneUnderstandingBase::AddSphereBound(const FVector& Center, float Radius)
+	{
+		SphereBounds.Add(FSphere(Center, Radius));
 	}
 
-	void FSceneUnderstandingBase::ComputeNewScene(XrTime DisplayTime)
+	void FSceneUnderstandingBase::AddBoxBound(const FTransform& Transform, const FVector& Extent)
+	{
+		BoxBounds.Add({Transform, Extent});
+	}
+
+	void FSceneUnderstandingBase::AddFrustumBound(const FTransform& Transform, float HorizontalFOV, float VerticalFOV, float FarDistance)
+	{
+		FrustumBounds.Add({Transform, HorizontalFOV, VerticalFOV, FarDistance});
+	}
+
+	void FSceneUnderstandingBase::ClearBounds()
+	{
+		SphereBounds.Reset();
+		BoxBounds.Reset();
+		FrustumBounds.Reset();
+	}
+
+	void FSceneUnderstandingBase::ComputeNewScene(XrTime DisplayTime, XrSpace TrackingSpace)
 	{
 		SceneComputeInfo.requestedFeatureCount = static_cast<uint32_t>(ComputeFeatures.Num());
 		SceneComputeInfo.requestedFeatures = ComputeFeatures.GetData();
 		SceneComputeInfo.consistency = GetSceneComputeConsistency();
-		SceneComputeInfo.bounds.space = ViewSpace.Handle();	  // scene bounds will be relative to view space
 		SceneComputeInfo.bounds.time = DisplayTime;
 
-		if (BoundHeight > 0)
+		SceneSpheres.Reset();
+		SceneBoxes.Reset();
+		SceneFrustums.Reset();
+		if (SphereBounds.Num() == 0 && BoxBounds.Num() == 0 && FrustumBounds.Num() == 0)
 		{
-			SceneBox.pose = { {0, 0, 0, 1}, {0, 0, 0} };
-			SceneBox.extents = { SphereBoundRadius, BoundHeight, SphereBoundRadius };
-			SceneComputeInfo.bounds.boxCount = 1;
-			SceneComputeInfo.bounds.boxes = &SceneBox;
+			SceneComputeInfo.bounds.space = ViewSpace.Handle();	  // scene bounds will be relative to view space
+			if (BoundHeight > 0)
+			{
+				SceneBoxes.Add({{{0, 0, 0, 1}, {0, 0, 0}}, {SphereBoundRadius, BoundHeight, SphereBoundRadius}});
+			}
+			else
+			{
+				SceneSpheres.Add({{0, 0, 0}, SphereBoundRadius});
+			}
 		}
 		else
 		{
-			SceneSphere.center = { 0, 0, 0 };
-			SceneSphere.radius = SphereBoundRadius;
-			SceneComputeInfo.bounds.sphereCount = 1;
-			SceneComputeInfo.bounds.spheres = &SceneSphere;
+			// World space bounds are converted to tracking space each compute, in case the tracking origin or AR alignment moved.
+			// This is the inverse of the transform traces use, so bounds and traces agree on where the world is.
+			SceneComputeInfo.bounds.space = TrackingSpace;
+			const float WorldToMetersScale = XRTrackingSystem->GetWorldToMetersScale();
+			const FTransform WorldToTracking =
+				(UARBlueprintLibrary::GetAlignmentTransform() * XRTrackingSystem->GetTrackingToWorldTransform()).Inverse();
+			ConvertSceneBounds(
+				SphereBounds, BoxBounds, FrustumBounds, WorldToTracking, WorldToMetersScale, SceneSpheres, SceneBoxes, SceneFrustums);
 		}
 
+		SceneComputeInfo.bounds.sphereCount = static_cast<uint32_t>(SceneSpheres.Num());
+		SceneComputeInfo.bounds.spheres = SceneSpheres.GetData();
+		SceneComputeInfo.bounds.boxCount = static_cast<uint32_t>(SceneBoxes.Num());
+		SceneComputeInfo.bounds.boxes = SceneBoxes.GetData();
+		SceneComputeInfo.bounds.frustumCount = static_cast<uint32_t>(SceneFrustums.Num());
+		SceneComputeInfo.bounds.frustums = SceneFrustums.GetData();
+
 		XR_ENSURE(Ext.xrComputeNewSceneMSFT(SceneObserver.Handle(), &SceneComputeInfo));
 	}
 }
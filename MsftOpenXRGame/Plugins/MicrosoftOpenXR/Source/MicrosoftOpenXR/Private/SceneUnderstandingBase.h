@@ -8,11 +8,16 @@
 #include "IOpenXRARModule.h"
 #include "IOpenXRARTrackedGeometryHolder.h"
 #include "IXRTrackingSystem.h"
+#include "MeshBufferPool.h"
 #include "MicrosoftOpenXR.h"
 #include "Misc/EngineVersionComparison.h"
 #include "OpenXRCore.h"
+#include "SceneCache.h"
 #include "SceneUnderstandingUtility.h"
 #include "TrackedGeometryCollision.h"
+#include "TrackedGeometrySpatialIndex.h"
+#include "TrackedGeometryTrace.h"
+#include "TrackedMeshData.h"
 #include "UniqueHandle.h"
 
 #if SUPPORTS_REMOTING
@@ -23,11 +28,11 @@ class IOpenXRARTrackedMeshHolder;
 
 namespace MicrosoftOpenXR
 {
+	// Game thread stage of the latest processed scan.
+	// Computing and reading the following scans overlaps with these stages.
 	enum class EScanState
 	{
 		Idle,
-		Waiting,
-		Processing,
 		AddMeshesToScene,
 		Locating
 	};
@@ -35,15 +40,81 @@ namespace MicrosoftOpenXR
 	struct FPlaneData
 	{
 		FGuid MeshGuid;
+
+		// Hashes of the plane and mesh data submitted for this component in the previous scan.
+		// Zero means the data has not been submitted and must be sent again.
+		uint64 PlaneHash = 0;
+		uint64 MeshHash = 0;
+
+		// The runtime's update time of the component, its mesh buffers are not read again while this and Type are unchanged.
+		XrTime UpdateTime = 0;
+		// The classification the mesh was submitted with, which the mesh update time does not cover.
+		EARObjectClassification Type = EARObjectClassification::NotApplicable;
+	};
+
+	struct FMeshLODSettings
+	{
+		// Number of simplified levels generated for each visual mesh, zero disables mesh LODs.
+		int32 NumLODs = 0;
+		// Cluster size in meters of the first simplified level, doubled for each further level.
+		float CellSize = 0.1f;
+		// Distance in meters from the head covered by each level.
+		float LODDistance = 3.0f;
+	};
+
+	// World space volumes that scans are limited to.
+	struct FBoxBound
+	{
+		FTransform Transform;
+		// Half the size of the box along each axis, before the transform's scale.
+		FVector Extent;
 	};
 
+	struct FFrustumBound
+	{
+		// The frustum looks along the transform's forward axis.
+		FTransform Transform;
+		// Full angles in degrees.
+		float HorizontalFOV;
+		float VerticalFOV;
+		float FarDistance;
+	};
+
+	/// <summary>
+	/// Orders component indices by how near and in view of the head their locations are, most relevant first.
+	/// Components that were not located go last, and components of equal weight keep their order.
+	/// </summary>
+	void SortComponentsByView(TArray<int32>& InOutIndices, const TArray<XrSceneComponentLocationMSFT>& Locations,
+		const FVector& HeadPosition, const FVector& HeadForward, float WorldToMetersScale, TArray<TPair<float, int32>>& Scratch);
+
+	/// <summary>
+	/// Converts world space scan bounds to OpenXR bounds in the tracking space WorldToTracking leads to.
+	/// The output arrays are appended to.
+	/// </summary>
+	void ConvertSceneBounds(const TArray<FSphere>& Spheres, const TArray<FBoxBound>& Boxes, const TArray<FFrustumBound>& Frustums,
+		const FTransform& WorldToTracking, float WorldToMetersScale, TArray<XrSceneSphereBoundMSFT>& OutSpheres,
+		TArray<XrSceneOrientedBoxBoundMSFT>& OutBoxes, TArray<XrSceneFrustumBoundMSFT>& OutFrustums);
+
 	struct FPlaneUpdate
 	{
 		FGuid MeshGuid;
-		EARObjectClassification Type;
-		FVector Extent;
-		TArray<FVector> Vertices;
-		TArray<MRMESH_INDEX_TYPE> Indices;
+		EARObjectClassification Type = EARObjectClassification::NotApplicable;
+		FVector Extent = FVector::ZeroVector;
+		// Shared with the mesh collision data, only kept after submission while other LODs may be needed.
+		FTrackedMeshDataPtr MeshData;
+
+		// Simplified versions of MeshData, LODs[0] is mesh LOD 1.
+		TArray<FTrackedMeshDataRef> LODs;
+		// Mesh LOD sent to the tracked mesh holder, INDEX_NONE until the mesh is submitted.
+		int32 SubmittedLOD = INDEX_NONE;
+
+		uint64 PlaneHash = 0;
+		uint64 MeshHash = 0;
+		XrTime UpdateTime = 0;
+
+		// False when the data matches the previous scan, the existing tracked geometry is kept as is.
+		bool bPlaneChanged = true;
+		bool bMeshChanged = true;
 	};
 
 	struct FSceneUpdate
@@ -51,8 +122,14 @@ namespace MicrosoftOpenXR
 		FSceneHandle Scene;
 		TMap<XrUuidMSFT, FPlaneUpdate> Planes;
 		TArray<XrUuidMSFT> PlaneUuids;
+		// Locations of PlaneUuids when the scene was loaded, used to order the changed components and prioritize the first locates.
+		TArray<XrSceneComponentLocationMSFT> Locations;
 		TMap<FGuid, TrackedGeometryCollision> PlaneCollisionInfo;
 		TMap<FGuid, TrackedGeometryCollision> MeshCollisionInfo;
+		// Settings the mesh LODs of this scan were generated with.
+		FMeshLODSettings MeshLODSettings;
+		// Object types of this scan's scene, handed to the next scan's worker.
+		FSceneObjectTypeCache ObjectTypes;
 	};
 
 	class FSceneUnderstandingBase : public IOpenXRExtensionPlugin, public IOpenXRCustomCaptureSupport
@@ -63,8 +140,10 @@ namespace MicrosoftOpenXR
 
 		const void* OnCreateSession(XrInstance InInstance, XrSystemId InSystem, const void* InNext) override;
 		const void* OnBeginSession(XrSession InSession, const void* InNext) override;
+		void OnDestroySession(XrSession InSession) override;
 
 		bool GetRequiredExtensions(TArray<const ANSICHAR*>& OutExtensions) override;
+		bool GetOptionalExtensions(TArray<const ANSICHAR*>& OutExtensions) override;
 		bool OnToggleARCapture(const bool bOnOff) override;
 
 		IOpenXRCustomCaptureSupport* GetCustomCaptureSupport(const EARCaptureType CaptureType) override = 0;
@@ -76,8 +155,29 @@ namespace MicrosoftOpenXR
 			const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe> ARCompositionComponent, const FVector Start,
 			const FVector End, const EARLineTraceChannels TraceChannels) override;
 
+		/// <summary>
+		/// Trace a batch of world space segments against the located planes and meshes, keeping the closest hit per segment.
+		/// A result is only replaced by a closer hit, so several plugins can trace into the same results.
+		/// </summary>
+		void LineTraceTrackedObjects(const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe> ARCompositionComponent,
+			TArrayView<const FTrackedGeometryTraceSegment> Segments, bool bTracePlanes, bool bMultithreaded,
+			TArrayView<FTrackedGeometryTraceResult> InOutResults);
+
 		bool CanDetectPlanes();
 
+		void SetScanMode(ESceneScanMode Mode, float IntervalSeconds, float MovementThreshold);
+		void RequestScan();
+
+		/// <summary>
+		/// Limit the following scans to world space volumes instead of the default volume around the head.
+		/// Components outside every volume are removed by the next scan.
+		/// </summary>
+		void AddSphereBound(const FVector& Center, float Radius);
+		void AddBoxBound(const FTransform& Transform, const FVector& Extent);
+		void AddFrustumBound(const FTransform& Transform, float HorizontalFOV, float VerticalFOV, float FarDistance);
+		// Scan the default volume around the head again.
+		void ClearBounds();
+
 	protected:
 		virtual XrSceneComputeConsistencyMSFT GetSceneComputeConsistency() = 0;
 		virtual TArray<XrSceneComputeFeatureMSFT> GetSceneComputeFeatures(class UARSessionConfig* SessionConfig) = 0;
@@ -85,12 +185,65 @@ namespace MicrosoftOpenXR
 	private:
 		void UpdateObjectLocations(XrTime DisplayTime, XrSpace TrackingSpace);
 
-		void ProcessSceneUpdate(FSceneUpdate&& SceneUpdate, XrTime DisplayTime, XrSpace TrackingSpace);
+		// Takes over the new scan's data, and leaves the previous scan's data in SceneUpdate.
+		void ProcessSceneUpdate(FSceneUpdate& SceneUpdate, XrTime DisplayTime, XrSpace TrackingSpace);
 
 		void HandleEndPIE(const bool InIsSimulating);
 		void Stop();
+		// Stops scene understanding and destroys every handle owned by the session, before the session is destroyed.
+		void DestroySessionHandles();
+
+		void ComputeNewScene(XrTime DisplayTime, XrSpace TrackingSpace);
+		// Polls the scene compute, and keeps the observer computing while fewer than the maximum scenes are in flight.
+		void UpdateSceneCompute(XrTime DisplayTime, XrSpace TrackingSpace);
+		// Reads the newest computed scene on a background thread, dropping older computed scenes.
+		void StartReadingScene(XrTime DisplayTime, XrSpace TrackingSpace);
+		// Scenes computing, computed or being read, not counting the scene being shown.
+		int32 GetNumScenesInFlight() const;
+		// Applies the scan mode, and remembers when and where the scan it allows starts.
+		bool ShouldStartScan();
+
+		// Picks the mesh LOD for a component from its distance to the head, with some hysteresis around the current LOD.
+		int32 ChooseMeshLOD(const FPlaneUpdate& Plane, const XrSceneComponentLocationMSFT& Location, bool bHasHeadPose,
+			const FVector& HeadPosition, float WorldToMetersScale) const;
+		// Sends a mesh LOD to the tracked mesh holder, keeping the mesh data if other LODs may be needed later.
+		void SubmitMeshLOD(FPlaneUpdate& Plane, int32 LOD, const FTransform& LocalToTrackingTransform);
+
+		// Starts relocating every component of the current scene, a few components each frame.
+		void StartLocatePass();
+		// Picks the components to relocate this frame, favoring stale components near the user and in view.
+		void SelectComponentsToLocate(int32 Budget, TArray<int32>& OutIndices);
+		// Orders ChangedPlaneIndices so components near the user and in view are added first.
+		void SortChangedPlanesByView();
+		// Locates the components at the given indices into UuidsToLocate with a single call.
+		void LocateComponents(const TArray<int32>& Indices, XrTime DisplayTime, XrSpace TrackingSpace);
 
-		void ComputeNewScene(XrTime DisplayTime);
+		// Sends a component's latest location to the tracked mesh holder, hiding it while it is not located.
+		void SendPlaneLocation(const XrUuidMSFT& Uuid, const XrSceneComponentLocationMSFT& Location, float WorldToMetersScale);
+		void SendMeshLocation(const FGuid& MeshGuid, const XrSceneComponentLocationMSFT& Location, float WorldToMetersScale);
+		// Moves a component's plane and mesh bounds in the trace spatial indices to its latest location.
+		void UpdateTraceBounds(
+			const XrUuidMSFT& PlaneUuid, const FGuid& MeshGuid, const XrSceneComponentLocationMSFT& Location, float WorldToMetersScale);
+		class UARTrackedGeometry* FindTrackedGeometry(const FGuid& Id, bool& bInOutRefreshed);
+		// The collision data and spatial indices traced by both line trace paths.
+		FTrackedGeometryTraceScene GetTraceScene() const;
+		class UARTrackedGeometry* FindTraceGeometry(const FGuid& Id, bool& bInOutRefreshed, FTransform& OutLocalToWorld);
+
+		FString GetSceneCacheName();
+		FString GetSceneCachePath();
+		XrSpatialAnchorPersistenceNameMSFT GetSceneCacheAnchorName();
+		// Loads the cache anchor from the anchor store, and the cache keyed to it on a background thread.
+		void StartLoadingSceneCache();
+		// Shows the loaded cache until the first scan replaces it, once its anchor has been located.
+		void ApplySceneCache(XrTime DisplayTime, XrSpace TrackingSpace);
+		// Moves the cached components with their anchor until the first scan replaces them.
+		void UpdateCachedComponentLocations(XrTime DisplayTime, XrSpace TrackingSpace);
+		// Writes the current scene to the cache on a background thread, relative to the cache anchor.
+		void WriteSceneCache(XrTime DisplayTime, XrSpace TrackingSpace);
+		bool CreateSceneCacheAnchor(XrTime DisplayTime);
+		// Takes ownership of an anchor and creates its space, destroying the anchor on failure.
+		bool SetSceneCacheAnchor(XrSpatialAnchorMSFT Anchor);
+		void DestroySceneCacheAnchor();
 
 		ExtensionDispatchTable Ext{};
 
@@ -107,19 +260,110 @@ namespace MicrosoftOpenXR
 		TMap<XrUuidMSFT, FPlaneUpdate> Planes;
 		TArray<XrSceneComponentLocationMSFT> Locations;
 		TMap<XrUuidMSFT, FPlaneData> PreviousPlanes;
-		int UuidToLocateThisFrame = 0;
-		int UuidsToLocatePerFrame = 5;
+		// Indices into UuidsToLocate of the components that were added or changed in the latest scan, in the order they are added.
+		TArray<int32> ChangedPlaneIndices;
+		int ChangedPlaneToAddThisFrame = 0;
+		// Settings the LODs of the current scene were generated with.
+		FMeshLODSettings MeshLODSettings;
+
+		// Per-frame budget that follows the measured cost of a unit of work,
+		// and backs off while the game thread is over its target frame time.
+		struct FAdaptiveFrameBudget
+		{
+			float Units = 1.0f;
+			double SecondsPerUnit = 0.0;
+
+			int32 GetUnits(int32 MaxUnits);
+			void Update(int32 UnitsDone, double ElapsedSeconds);
+		};
+		// Measured in vertices of the components added each frame.
+		FAdaptiveFrameBudget AddMeshesBudget;
+		// Measured in components relocated each frame.
+		FAdaptiveFrameBudget LocateBudget;
+
+		// Frame number each component in UuidsToLocate was last located on.
+		TArray<uint64> LocatedFrames;
+		uint64 LocatePassStartFrame = 0;
+		int32 NumLocatedThisPass = 0;
+		// Scratch arrays reused by the per-frame locate slice.
+		TArray<int32> LocateSlice;
+		TArray<XrUuidMSFT> LocateSliceUuids;
+		TArray<XrSceneComponentLocationMSFT> LocateSliceLocations;
+		TArray<TPair<float, int32>> LocatePriorities;
 
 		TMap<FGuid, TrackedGeometryCollision> PlaneCollisionInfo;
 		TMap<FGuid, TrackedGeometryCollision> MeshCollisionInfo;
 
+		// Tracking space bounds of located planes and meshes, so line traces only test geometry along the ray.
+		FTrackedGeometrySpatialIndex PlaneSpatialIndex;
+		FTrackedGeometrySpatialIndex MeshSpatialIndex;
+		TMap<FGuid, TWeakObjectPtr<class UARTrackedGeometry>> TrackedGeometries;
+
+		// Scans are pipelined: the observer computes the next scene while earlier scenes are read and added.
+		bool bComputingScene = false;
+		// Scenes whose compute completed, oldest first, waiting for the reader.
+		TArray<FSceneHandle> ComputedScenes;
+		// Scenes are read one at a time, each against the hashes of the scan processed before it.
 		TFuture<TSharedPtr<FSceneUpdate>> SceneUpdateFuture;
+		// A read scan waiting for the previous scan to finish being added.
+		TSharedPtr<FSceneUpdate> ReadySceneUpdate;
+
+		TArray<FSphere> SphereBounds;
+		TArray<FBoxBound> BoxBounds;
+		TArray<FFrustumBound> FrustumBounds;
+
+		ESceneScanMode ScanMode = ESceneScanMode::Continuous;
+		float ScanIntervalSeconds = 5.0f;
+		float ScanMovementThreshold = 100.0f;
+		bool bScanRequested = false;
+		// Time and head position the latest scan started at.
+		double LastScanStartTime = 0.0;
+		TOptional<FVector> LastScanHeadPosition;
+		// The first scan after scene understanding starts begins right away, unless scans only start on request.
+		bool bScannedSinceStart = false;
+		// Scale the latest scene was read with.
+		float ReadSceneWorldToMetersScale = 0.0f;
+		// Object types of the latest processed scene, moved to the worker reading the next scene.
+		FSceneObjectTypeCache ObjectTypeCache;
+		// The previous scan's data, recycled by the next scan's worker.
+		TSharedPtr<FSceneUpdate> RecycledSceneUpdate;
+		TSharedRef<FMeshBufferPool, ESPMode::ThreadSafe> MeshBufferPool = MakeShared<FMeshBufferPool, ESPMode::ThreadSafe>();
+
+		// Members for the scene cache, which needs the spatial anchor and spatial anchor persistence extensions.
+		PFN_xrCreateSpatialAnchorMSFT xrCreateSpatialAnchorMSFT = nullptr;
+		PFN_xrCreateSpatialAnchorSpaceMSFT xrCreateSpatialAnchorSpaceMSFT = nullptr;
+		PFN_xrDestroySpatialAnchorMSFT xrDestroySpatialAnchorMSFT = nullptr;
+		PFN_xrCreateSpatialAnchorStoreConnectionMSFT xrCreateSpatialAnchorStoreConnectionMSFT = nullptr;
+		PFN_xrDestroySpatialAnchorStoreConnectionMSFT xrDestroySpatialAnchorStoreConnectionMSFT = nullptr;
+		PFN_xrPersistSpatialAnchorMSFT xrPersistSpatialAnchorMSFT = nullptr;
+		PFN_xrUnpersistSpatialAnchorMSFT xrUnpersistSpatialAnchorMSFT = nullptr;
+		PFN_xrCreateSpatialAnchorFromPersistedNameMSFT xrCreateSpatialAnchorFromPersistedNameMSFT = nullptr;
+		bool bCanCacheScenes = false;
+		XrSession Session = XR_NULL_HANDLE;
+		XrSpatialAnchorStoreConnectionMSFT SceneCacheAnchorStore = XR_NULL_HANDLE;
+		XrSpatialAnchorMSFT SceneCacheAnchor = XR_NULL_HANDLE;
+		XrSpace SceneCacheAnchorSpace = XR_NULL_HANDLE;
+		TFuture<TSharedPtr<FSceneCache>> SceneCacheFuture;
+		TFuture<bool> SceneCacheSaveFuture;
+		struct FCachedComponent
+		{
+			XrUuidMSFT Uuid;
+			XrPosef PoseInAnchorSpace;
+		};
+		// Components shown from the cache, located through the cache anchor until the first scan.
+		TArray<FCachedComponent> CachedComponents;
+		FTransform CachedAnchorToTracking;
+		double LastSceneCacheSaveTime = 0.0;
+		// True when the scene changed since it was last written to the cache.
+		bool bSceneCacheDirty = false;
 
 		class IXRTrackingSystem* XRTrackingSystem = nullptr;
 		IOpenXRARTrackedMeshHolder* TrackedMeshHolder = nullptr;
 		XrNewSceneComputeInfoMSFT SceneComputeInfo{ XR_TYPE_NEW_SCENE_COMPUTE_INFO_MSFT };
-		XrSceneOrientedBoxBoundMSFT SceneBox;
-		XrSceneSphereBoundMSFT SceneSphere;
+		// Bounds of the latest compute, converted to the space SceneComputeInfo.bounds is relative to.
+		TArray<XrSceneSphereBoundMSFT> SceneSpheres;
+		TArray<XrSceneOrientedBoxBoundMSFT> SceneBoxes;
+		TArray<XrSceneFrustumBoundMSFT> SceneFrustums;
 		float SphereBoundRadius = 10.0f;	// meters
 		float BoundHeight = 0.0f;			// meters
 		bool bShouldStartSceneUnderstanding = false;
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "MeshBufferPool.h"
 #include "OpenXRCommon.h"
 #include "UniqueHandle.h"
 
@@ -112,44 +113,96 @@ namespace MicrosoftOpenXR
 		}
 	}
 
-	inline XrSceneObjectTypeMSFT GetObjectType(const TMap<XrUuidMSFT, XrSceneObjectTypeMSFT>& ObjectTypeMap, const XrUuidMSFT& Uuid)
+	/// <summary>
+	/// Types of the scene objects of the latest scene, kept across scans so each scan only updates the objects
+	/// that are new or whose update time changed.
+	/// </summary>
+	class FSceneObjectTypeCache
 	{
-		const auto* Value = ObjectTypeMap.Find(Uuid);
-		return Value != nullptr ? *Value : XR_SCENE_OBJECT_TYPE_UNCATEGORIZED_MSFT;
-	}
-
-	// Maps a SceneObject's UUID to an ObjectType.
-	inline TMap<XrUuidMSFT, XrSceneObjectTypeMSFT> GetObjectTypeMap(XrSceneMSFT SceneHandle, const ExtensionDispatchTable& Ext)
-	{
-		XrSceneComponentsGetInfoMSFT GetInfo{XR_TYPE_SCENE_COMPONENTS_GET_INFO_MSFT};
-		GetInfo.componentType = XR_SCENE_COMPONENT_TYPE_OBJECT_MSFT;
+	public:
+		void Update(XrSceneMSFT SceneHandle, const ExtensionDispatchTable& Ext)
+		{
+			XrSceneComponentsGetInfoMSFT GetInfo{XR_TYPE_SCENE_COMPONENTS_GET_INFO_MSFT};
+			GetInfo.componentType = XR_SCENE_COMPONENT_TYPE_OBJECT_MSFT;
+
+			XrSceneComponentsMSFT SceneComponents{XR_TYPE_SCENE_COMPONENTS_MSFT};
+			XrSceneObjectsMSFT SceneObjects{XR_TYPE_SCENE_OBJECTS_MSFT};
+			const auto ReadComponents = [&]() {
+				SceneComponents.next = nullptr;
+				SceneComponents.componentCapacityInput = static_cast<uint32_t>(Components.Num());
+				SceneComponents.components = Components.GetData();
+				if (Components.Num() > 0)
+				{
+					SceneObjects.sceneObjectCount = static_cast<uint32_t>(Objects.Num());
+					SceneObjects.sceneObjects = Objects.GetData();
+					InsertExtensionStruct(SceneComponents, SceneObjects);
+				}
+				return Ext.xrGetSceneComponentsMSFT(SceneHandle, &GetInfo, &SceneComponents);
+			};
+
+			// Scenes usually hold about as many objects as the previous scene,
+			// so the buffers sized for it can usually be filled without asking for the count first.
+			XrResult Result = ReadComponents();
+			if (Result == XR_ERROR_SIZE_INSUFFICIENT ||
+				(XR_SUCCEEDED(Result) && SceneComponents.componentCountOutput > static_cast<uint32_t>(Components.Num())))
+			{
+				Components.SetNum(SceneComponents.componentCountOutput);
+				Objects.SetNum(SceneComponents.componentCountOutput);
+				Result = ReadComponents();
+			}
+			if (!XR_ENSURE(Result))
+			{
+				Entries.Reset();
+				return;
+			}
+
+			++Generation;
+			for (uint32_t Index = 0; Index < SceneComponents.componentCountOutput; Index++)
+			{
+				const XrSceneComponentMSFT& Component = Components[Index];
+				FEntry* Entry = Entries.Find(Component.id);
+				if (Entry == nullptr)
+				{
+					Entry = &Entries.Add(Component.id, {Objects[Index].objectType, Component.updateTime});
+				}
+				else if (Entry->UpdateTime != Component.updateTime)
+				{
+					Entry->Type = Objects[Index].objectType;
+					Entry->UpdateTime = Component.updateTime;
+				}
+				Entry->Generation = Generation;
+			}
+
+			// Forget the objects that are no longer in the scene.
+			for (auto It = Entries.CreateIterator(); It; ++It)
+			{
+				if (It.Value().Generation != Generation)
+				{
+					It.RemoveCurrent();
+				}
+			}
+		}
 
-		XrSceneComponentsMSFT SceneComponents{XR_TYPE_SCENE_COMPONENTS_MSFT};
-		XR_ENSURE(Ext.xrGetSceneComponentsMSFT(SceneHandle, &GetInfo, &SceneComponents));
-		const uint32_t Count = SceneComponents.componentCountOutput;
+		XrSceneObjectTypeMSFT GetObjectType(const XrUuidMSFT& Uuid) const
+		{
+			const FEntry* Entry = Entries.Find(Uuid);
+			return Entry != nullptr ? Entry->Type : XR_SCENE_OBJECT_TYPE_UNCATEGORIZED_MSFT;
+		}
 
+	private:
+		struct FEntry
+		{
+			XrSceneObjectTypeMSFT Type;
+			XrTime UpdateTime;
+			uint32 Generation = 0;
+		};
+
+		TMap<XrUuidMSFT, FEntry> Entries;
+		uint32 Generation = 0;
+		// Buffers for reading the scene objects, sized for the largest scene read so far.
 		TArray<XrSceneComponentMSFT> Components;
-		Components.SetNum(Count);
-		SceneComponents.componentCapacityInput = Count;
-		SceneComponents.components = Components.GetData();
-
 		TArray<XrSceneObjectMSFT> Objects;
-		Objects.SetNum(Count);
-		XrSceneObjectsMSFT sceneObjects{XR_TYPE_SCENE_OBJECTS_MSFT};
-		sceneObjects.sceneObjectCount = Count;
-		sceneObjects.sceneObjects = Objects.GetData();
-		InsertExtensionStruct(SceneComponents, sceneObjects);
-
-		XR_ENSURE(Ext.xrGetSceneComponentsMSFT(SceneHandle, &GetInfo, &SceneComponents));
-
-		TMap<XrUuidMSFT, XrSceneObjectTypeMSFT> Map;
-		Map.Reserve(Count);
-		for (uint32_t Index = 0; Index < Count; Index++)
-		{
-			Map.Add(Components[Index].id, Objects[Index].objectType);
-		}
-		return Map;
-	}
+	};
 
 	inline void GetSceneVisibleMeshes(XrSceneMSFT SceneHandle, const ExtensionDispatchTable& Ext,
 		const TArray<XrScenePlaneAlignmentTypeMSFT>& PlaneAlignmentFilters, TArray<XrSceneComponentMSFT>& Components,
@@ -228,9 +281,26 @@ namespace MicrosoftOpenXR
 		XR_ENSURE(Ext.xrLocateSceneComponentsMSFT(SceneHandle, &LocateInfo, &ComponentLocations));
 	}
 
-	// Reads mesh vertices and 32-bit indices.
+	// The pool only holds index buffers of MRMESH_INDEX_TYPE, other index buffers are allocated as usual.
+	template <typename IndexType>
+	void AcquireMeshBuffers(FMeshBufferPool* Pool, TArray<FVector>& VertexBuffer, TArray<IndexType>& IndexBuffer,
+		uint32_t VertexCount, uint32_t IndexCount)
+	{
+		if (Pool == nullptr)
+		{
+			return;
+		}
+
+		Pool->Vertices.Acquire(VertexBuffer, VertexCount);
+		if constexpr (std::is_same<IndexType, MRMESH_INDEX_TYPE>::value)
+		{
+			Pool->Indices.Acquire(IndexBuffer, IndexCount);
+		}
+	}
+
+	// Reads mesh vertices and 32-bit indices, into buffers from the pool if one is given.
 	inline void ReadMeshBuffers(XrSceneMSFT SceneHandle, const ExtensionDispatchTable& Ext, uint64_t MeshBufferId,
-		TArray<FVector>& VertexBuffer, TArray<uint32_t>& IndexBuffer)
+		TArray<FVector>& VertexBuffer, TArray<uint32_t>& IndexBuffer, FMeshBufferPool* Pool = nullptr)
 	{
 		static_assert(sizeof(XrVector3f) == sizeof(FVector));
 		XrSceneMeshBuffersGetInfoMSFT MeshGetInfo{XR_TYPE_SCENE_MESH_BUFFERS_GET_INFO_MSFT};
@@ -243,6 +313,7 @@ namespace MicrosoftOpenXR
 		InsertExtensionStruct(MeshBuffers, Indices);
 		XR_ENSURE(Ext.xrGetSceneMeshBuffersMSFT(SceneHandle, &MeshGetInfo, &MeshBuffers));
 
+		AcquireMeshBuffers(Pool, VertexBuffer, IndexBuffer, Vertices.vertexCountOutput, Indices.indexCountOutput);
 		VertexBuffer.SetNum(Vertices.vertexCountOutput);
 		IndexBuffer.SetNum(Indices.indexCountOutput);
 		Vertices.vertexCapacityInput = Vertices.vertexCountOutput;
@@ -254,9 +325,9 @@ namespace MicrosoftOpenXR
 		IndexBuffer.SetNum(Indices.indexCountOutput);
 	}
 
-	// Reads mesh vertices and 16-bit indices.
+	// Reads mesh vertices and 16-bit indices, into buffers from the pool if one is given.
 	inline void ReadMeshBuffers(XrSceneMSFT SceneHandle, const ExtensionDispatchTable& Ext, uint64_t MeshBufferId,
-		TArray<FVector>& VertexBuffer, TArray<uint16_t>& IndexBuffer)
+		TArray<FVector>& VertexBuffer, TArray<uint16_t>& IndexBuffer, FMeshBufferPool* Pool = nullptr)
 	{
 		static_assert(sizeof(XrVector3f) == sizeof(FVector));
 		XrSceneMeshBuffersGetInfoMSFT MeshGetInfo{XR_TYPE_SCENE_MESH_BUFFERS_GET_INFO_MSFT};
@@ -269,6 +340,7 @@ namespace MicrosoftOpenXR
 		InsertExtensionStruct(MeshBuffers, Indices);
 		XR_ENSURE(Ext.xrGetSceneMeshBuffersMSFT(SceneHandle, &MeshGetInfo, &MeshBuffers));
 
+		AcquireMeshBuffers(Pool, VertexBuffer, IndexBuffer, Vertices.vertexCountOutput, Indices.indexCountOutput);
 		VertexBuffer.SetNum(Vertices.vertexCountOutput);
 		IndexBuffer.SetNum(Indices.indexCountOutput);
 		Vertices.vertexCapacityInput = Vertices.vertexCountOutput;
@@ -4,6 +4,7 @@
 #include "SpatialAnchorPlugin.h"
 #include "OpenXRCore.h"
 #include "ARPin.h"
+#include "SceneCache.h"
 
 #include "GameDelegates.h"
 
@@ -263,6 +264,12 @@ namespace MicrosoftOpenXR
 
 			for (const XrSpatialAnchorPersistenceNameMSFT& AnchorName : AnchorNames)
 			{
+				if (IsSceneCacheAnchorName(AnchorName.name))
+				{
+					// Owned by scene understanding, not an ARPin.
+					continue;
+				}
+
 				auto NewPin = OnCreatePin(FName(AnchorName.name));
 
 				if (NewPin == nullptr)
@@ -0,0 +1,146 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "HandMeshPlugin.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		// Roughly the size of a HoloLens 2 hand mesh.
+		constexpr int32 VertexCount = 1500;
+		constexpr int32 TriangleCount = 2800;
+
+		// A tracked frame with random vertices, normals and triangles, its indices doubled like the runtime's.
+		FHandMeshPlugin::FHandMeshFrame MakeHandMeshFrame(uint32_t IndexBufferKey, FRandomStream& Random)
+		{
+			FHandMeshPlugin::FHandMeshFrame Frame;
+			Frame.TrackingState = EARTrackingState::Tracking;
+			Frame.LocalToTrackingTransform = FTransform(FRotator(10.0f, 20.0f, 30.0f), FVector(20.0f, -5.0f, 140.0f));
+			for (int32 Index = 0; Index < VertexCount; ++Index)
+			{
+				Frame.Vertices.Add(Random.VRand() * Random.FRandRange(0.0f, 10.0f));
+				Frame.Normals.Add(Random.VRand());
+			}
+
+			TSharedRef<FHandMeshPlugin::FHandMeshIndices, ESPMode::ThreadSafe> Indices =
+				MakeShared<FHandMeshPlugin::FHandMeshIndices, ESPMode::ThreadSafe>();
+			Indices->Key = IndexBufferKey;
+			for (int32 Triangle = 0; Triangle < TriangleCount; ++Triangle)
+			{
+				const int32 Corners[3] = {Random.RandRange(0, VertexCount - 1), Random.RandRange(0, VertexCount - 1), Random.RandRange(0, VertexCount - 1)};
+				for (const int32 Corner : {Corners[2], Corners[1], Corners[0], Corners[0], Corners[1], Corners[2]})
+				{
+					Indices->Indices.Add(static_cast<MRMESH_INDEX_TYPE>(Corner));
+					Indices->PackedIndices.Add(static_cast<uint16>(Corner));
+				}
+			}
+			Frame.Indices = Indices;
+			return Frame;
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandMeshPackedCopyTest, "MicrosoftOpenXR.HandMesh.PackedCopy",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FHandMeshPackedCopyTest::RunTest(const FString& Parameters)
+	{
+		FRandomStream Random(4321);
+		const FHandMeshPlugin::FHandMeshFrame Frame = MakeHandMeshFrame(7, Random);
+
+		TArray<FVector> Vertices, Normals;
+		TArray<int32> Indices;
+		TestTrue(TEXT("A tracked frame is copied"), FHandMeshPlugin::CopyHandMeshFrame(Frame, Vertices, Normals, Indices));
+
+		FPackedHandMeshData Packed;
+		TestTrue(TEXT("A tracked frame is packed"), FHandMeshPlugin::CopyPackedHandMeshFrame(Frame, Packed));
+		TestTrue(TEXT("The first packed copy writes the indices"), Packed.bIndicesChanged);
+		TestTrue(TEXT("The packed index buffer key is the frame's"), Packed.IndexBufferKey == 7);
+		TestEqual(TEXT("Packed and unpacked vertex counts"), Packed.Positions.Num(), Vertices.Num());
+		TestEqual(TEXT("Packed and unpacked normal counts"), Packed.Normals.Num(), Normals.Num());
+		TestEqual(TEXT("Packed and unpacked index counts"), Packed.Indices.Num(), Indices.Num());
+
+		int32 Mismatches = 0;
+		for (int32 Index = 0; Index < FMath::Min(Packed.Positions.Num(), Vertices.Num()); ++Index)
+		{
+			// Signed 8 bit normals are within one step of 1/127 per component.
+			Mismatches += Packed.Positions[Index] == Vertices[Index] && Packed.Normals[Index].ToFVector().Equals(Normals[Index], 2.0f / 127.0f) ? 0 : 1;
+		}
+		for (int32 Index = 0; Index < FMath::Min(Packed.Indices.Num(), Indices.Num()); ++Index)
+		{
+			Mismatches += Packed.Indices[Index] == Indices[Index] ? 0 : 1;
+		}
+		TestEqual(TEXT("Packed vertices, normals and indices match the unpacked copy"), Mismatches, 0);
+
+		TestTrue(TEXT("The same frame is packed again"), FHandMeshPlugin::CopyPackedHandMeshFrame(Frame, Packed));
+		TestFalse(TEXT("Unchanged indices are not rewritten"), Packed.bIndicesChanged);
+
+		const FHandMeshPlugin::FHandMeshFrame NewTopology = MakeHandMeshFrame(8, Random);
+		TestTrue(TEXT("A frame with new indices is packed"), FHandMeshPlugin::CopyPackedHandMeshFrame(NewTopology, Packed));
+		TestTrue(TEXT("New indices are rewritten"), Packed.bIndicesChanged);
+
+		FHandMeshPlugin::FHandMeshFrame Untracked = Frame;
+		Untracked.TrackingState = EARTrackingState::NotTracking;
+		TestFalse(TEXT("An untracked frame is not copied"), FHandMeshPlugin::CopyHandMeshFrame(Untracked, Vertices, Normals, Indices));
+		TestFalse(TEXT("An untracked frame is not packed"), FHandMeshPlugin::CopyPackedHandMeshFrame(Untracked, Packed));
+
+		return true;
+	}
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandMeshPackedCopyPerformanceTest, "MicrosoftOpenXR.HandMesh.PackedCopyPerformance",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+	bool FHandMeshPackedCopyPerformanceTest::RunTest(const FString& Parameters)
+	{
+		constexpr int32 Iterations = 2000;
+
+		FRandomStream Random(8765);
+		const FHandMeshPlugin::FHandMeshFrame Frame = MakeHandMeshFrame(1, Random);
+
+		auto Time = [](TFunctionRef<void()> Copy) {
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Copy();
+			}
+			return (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+		};
+
+		// Counting the copied elements keeps the copies from being optimized away.
+		int64 CopiedElements = 0;
+
+		// A caller that keeps its arrays, and one that passes new arrays every frame.
+		TArray<FVector> Vertices, Normals;
+		TArray<int32> Indices;
+		const double ReusedTime = Time([&]() {
+			FHandMeshPlugin::CopyHandMeshFrame(Frame, Vertices, Normals, Indices);
+			CopiedElements += Vertices.Num() + Normals.Num() + Indices.Num();
+		});
+		const double NewArraysTime = Time([&]() {
+			TArray<FVector> NewVertices, NewNormals;
+			TArray<int32> NewIndices;
+			FHandMeshPlugin::CopyHandMeshFrame(Frame, NewVertices, NewNormals, NewIndices);
+			CopiedElements += NewVertices.Num() + NewNormals.Num() + NewIndices.Num();
+		});
+
+		FPackedHandMeshData Packed;
+		const double PackedTime = Time([&]() {
+			FHandMeshPlugin::CopyPackedHandMeshFrame(Frame, Packed);
+			CopiedElements += Packed.Positions.Num() + Packed.Normals.Num() + (Packed.bIndicesChanged ? Packed.Indices.Num() : 0);
+		});
+
+		AddInfo(FString::Printf(TEXT("%d vertices, %d indices: GetHandMeshData copy %.4f ms with reused arrays, %.4f ms with new arrays, ")
+								TEXT("packed copy %.4f ms per call (%lld elements copied)."),
+			Frame.Vertices.Num(), Frame.Indices->Indices.Num(), ReusedTime, NewArraysTime, PackedTime, CopiedElements));
+		TestFalse(TEXT("The packed copy only writes the indices once"), Packed.bIndicesChanged);
+
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,144 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "MeshSimplification.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		constexpr int32 GridSize = 21;
+		constexpr float GridSpacing = 10.0f;
+
+		// A flat square grid on the XY plane, its triangles facing +Z.
+		void MakeGrid(TArray<FVector>& OutVertices, TArray<MRMESH_INDEX_TYPE>& OutIndices)
+		{
+			for (int32 Y = 0; Y < GridSize; ++Y)
+			{
+				for (int32 X = 0; X < GridSize; ++X)
+				{
+					OutVertices.Add(FVector(X * GridSpacing, Y * GridSpacing, 0.0f));
+				}
+			}
+			for (int32 Y = 0; Y < GridSize - 1; ++Y)
+			{
+				for (int32 X = 0; X < GridSize - 1; ++X)
+				{
+					const int32 Corner = Y * GridSize + X;
+					for (const int32 Index : {Corner, Corner + 1, Corner + GridSize + 1, Corner, Corner + GridSize + 1, Corner + GridSize})
+					{
+						OutIndices.Add(static_cast<MRMESH_INDEX_TYPE>(Index));
+					}
+				}
+			}
+		}
+
+		// Checks that every triangle indexes the simplified vertices, is not degenerate, faces +Z and appears once.
+		void TestTriangles(
+			FAutomationTestBase& Test, const TCHAR* What, const TArray<FVector>& Vertices, const TArray<MRMESH_INDEX_TYPE>& Indices)
+		{
+			if (Indices.Num() % 3 != 0)
+			{
+				Test.AddError(FString::Printf(TEXT("%s: %d indices is not a triangle list."), What, Indices.Num()));
+				return;
+			}
+
+			TSet<FIntVector> Triangles;
+			for (int32 Triangle = 0; Triangle < Indices.Num() / 3; ++Triangle)
+			{
+				const int32 I0 = Indices[Triangle * 3];
+				const int32 I1 = Indices[Triangle * 3 + 1];
+				const int32 I2 = Indices[Triangle * 3 + 2];
+				if (!Vertices.IsValidIndex(I0) || !Vertices.IsValidIndex(I1) || !Vertices.IsValidIndex(I2))
+				{
+					Test.AddError(FString::Printf(TEXT("%s: triangle %d indexes past the vertices."), What, Triangle));
+					continue;
+				}
+				if (I0 == I1 || I1 == I2 || I0 == I2)
+				{
+					Test.AddError(FString::Printf(TEXT("%s: triangle %d is degenerate."), What, Triangle));
+					continue;
+				}
+				if (FVector::CrossProduct(Vertices[I1] - Vertices[I0], Vertices[I2] - Vertices[I0]).Z <= 0.0f)
+				{
+					Test.AddError(FString::Printf(TEXT("%s: triangle %d does not face +Z."), What, Triangle));
+				}
+
+				// The same triangle in any rotation of its corners.
+				const int32 First = FMath::Min3(I0, I1, I2);
+				const FIntVector Key = First == I0 ? FIntVector(I0, I1, I2) : First == I1 ? FIntVector(I1, I2, I0) : FIntVector(I2, I0, I1);
+				if (Triangles.Contains(Key))
+				{
+					Test.AddError(FString::Printf(TEXT("%s: triangle %d is a duplicate."), What, Triangle));
+				}
+				Triangles.Add(Key);
+			}
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshSimplificationGridTest, "MicrosoftOpenXR.MeshSimplification.FlatGrid",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FMeshSimplificationGridTest::RunTest(const FString& Parameters)
+	{
+		TArray<FVector> Vertices;
+		TArray<MRMESH_INDEX_TYPE> Indices;
+		MakeGrid(Vertices, Indices);
+
+		TArray<FVector> OutVertices;
+		TArray<MRMESH_INDEX_TYPE> OutIndices;
+		SimplifyMeshByClustering(Vertices, Indices, GridSpacing * 5.0f, OutVertices, OutIndices);
+
+		// The grid spans five cells along each axis.
+		TestEqual(TEXT("One vertex per occupied cell"), OutVertices.Num(), 25);
+		TestTrue(TEXT("Triangles are kept"), OutIndices.Num() > 0);
+		TestTrue(TEXT("Triangles are removed"), OutIndices.Num() < Indices.Num());
+		TestTriangles(*this, TEXT("Large cells"), OutVertices, OutIndices);
+		for (const FVector& Vertex : OutVertices)
+		{
+			if (!FMath::IsNearlyZero(Vertex.Z, KINDA_SMALL_NUMBER))
+			{
+				AddError(FString::Printf(TEXT("Simplified vertex %s is off the grid's plane."), *Vertex.ToString()));
+			}
+		}
+
+		// Cells smaller than the grid spacing hold one vertex each, so nothing is merged.
+		SimplifyMeshByClustering(Vertices, Indices, GridSpacing * 0.5f, OutVertices, OutIndices);
+		TestEqual(TEXT("Small cells keep the vertices"), OutVertices.Num(), Vertices.Num());
+		TestEqual(TEXT("Small cells keep the triangles"), OutIndices.Num(), Indices.Num());
+		TestTriangles(*this, TEXT("Small cells"), OutVertices, OutIndices);
+
+		return true;
+	}
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshSimplificationCollapseTest, "MicrosoftOpenXR.MeshSimplification.Collapse",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FMeshSimplificationCollapseTest::RunTest(const FString& Parameters)
+	{
+		const TArray<FVector> Vertices = {FVector(1.0f, 1.0f, 0.0f), FVector(2.0f, 1.0f, 0.0f), FVector(2.0f, 2.0f, 0.0f)};
+		const TArray<MRMESH_INDEX_TYPE> Indices = {0, 1, 2};
+
+		TArray<FVector> OutVertices;
+		TArray<MRMESH_INDEX_TYPE> OutIndices;
+		SimplifyMeshByClustering(Vertices, Indices, 10.0f, OutVertices, OutIndices);
+		TestEqual(TEXT("A mesh within one cell collapses to one vertex"), OutVertices.Num(), 1);
+		TestEqual(TEXT("A mesh within one cell has no triangles"), OutIndices.Num(), 0);
+
+		SimplifyMeshByClustering(Vertices, Indices, 0.0f, OutVertices, OutIndices);
+		TestEqual(TEXT("No cell size gives no vertices"), OutVertices.Num(), 0);
+		TestEqual(TEXT("No cell size gives no triangles"), OutIndices.Num(), 0);
+
+		SimplifyMeshByClustering({}, {}, 10.0f, OutVertices, OutIndices);
+		TestEqual(TEXT("An empty mesh gives no vertices"), OutVertices.Num(), 0);
+		TestEqual(TEXT("An empty mesh gives no triangles"), OutIndices.Num(), 0);
+
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,241 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "SceneCache.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		// Offsets into the scene cache file format, see SceneCache.cpp.
+		constexpr int32 HeaderSize = 40;
+		constexpr int32 HeaderMagicOffset = 0;
+		constexpr int32 HeaderDataOffsetOffset = 24;
+		constexpr int32 HeaderDataSizeOffset = 32;
+		constexpr int32 RecordMeshOffsetOffset = 96;
+
+		template <typename T>
+		void WriteAt(TArray<uint8>& File, int32 Offset, T Value)
+		{
+			FMemory::Memcpy(File.GetData() + Offset, &Value, sizeof(Value));
+		}
+
+		template <typename T>
+		T ReadAt(const TArray<uint8>& File, int32 Offset)
+		{
+			T Value;
+			FMemory::Memcpy(&Value, File.GetData() + Offset, sizeof(Value));
+			return Value;
+		}
+
+		FString GetTestCachePath(const TCHAR* Name)
+		{
+			return FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("MicrosoftOpenXR"), FString(Name) + TEXT(".scenecache"));
+		}
+
+		XrUuidMSFT MakeUuid(uint8 Seed)
+		{
+			XrUuidMSFT Uuid;
+			for (int32 Index = 0; Index < UE_ARRAY_COUNT(Uuid.bytes); ++Index)
+			{
+				Uuid.bytes[Index] = static_cast<uint8>(Seed + Index);
+			}
+			return Uuid;
+		}
+
+		FSceneCacheComponent MakeComponent(uint8 Seed, bool bWithMeshGuid, FTrackedMeshDataPtr MeshData)
+		{
+			FSceneCacheComponent Component;
+			Component.Uuid = MakeUuid(Seed);
+			Component.MeshGuid = bWithMeshGuid ? FGuid(Seed, Seed + 1, Seed + 2, Seed + 3) : FGuid();
+			Component.PoseInAnchorSpace.orientation = {0.0f, 0.70710678f, 0.0f, 0.70710678f};
+			Component.PoseInAnchorSpace.position = {0.5f * Seed, -1.25f, 2.0f};
+			Component.Type = EARObjectClassification::Wall;
+			Component.Extent = FVector(10.0f * Seed, 20.0f, 0.0f);
+			Component.PlaneHash = 0x1234567890ABCDEFull + Seed;
+			Component.MeshHash = 0xFEDCBA0987654321ull + Seed;
+			Component.MeshData = MoveTemp(MeshData);
+			return Component;
+		}
+
+		FTrackedMeshDataPtr MakeGridMesh(int32 Size, MRMESH_INDEX_TYPE IndexOffset = 0)
+		{
+			TArray<FVector> Vertices;
+			TArray<MRMESH_INDEX_TYPE> Indices;
+			for (int32 Y = 0; Y <= Size; ++Y)
+			{
+				for (int32 X = 0; X <= Size; ++X)
+				{
+					Vertices.Add(FVector(X * 10.0f, Y * 10.0f, FMath::Sin(static_cast<float>(X + Y))));
+				}
+			}
+			for (int32 Y = 0; Y < Size; ++Y)
+			{
+				for (int32 X = 0; X < Size; ++X)
+				{
+					const MRMESH_INDEX_TYPE Corner = Y * (Size + 1) + X;
+					Indices.Append({Corner, static_cast<MRMESH_INDEX_TYPE>(Corner + 1), static_cast<MRMESH_INDEX_TYPE>(Corner + Size + 1)});
+					Indices.Append({static_cast<MRMESH_INDEX_TYPE>(Corner + 1), static_cast<MRMESH_INDEX_TYPE>(Corner + Size + 2),
+						static_cast<MRMESH_INDEX_TYPE>(Corner + Size + 1)});
+				}
+			}
+			for (MRMESH_INDEX_TYPE& Index : Indices)
+			{
+				Index += IndexOffset;
+			}
+			return MakeTrackedMeshData(MoveTemp(Vertices), MoveTemp(Indices));
+		}
+
+		bool LoadsModifiedCache(const TArray<uint8>& File, const FString& Path)
+		{
+			FSceneCache Cache;
+			Cache.Components.AddDefaulted();
+			const bool bLoaded = FFileHelper::SaveArrayToFile(File, *Path) && LoadSceneCache(Path, Cache);
+			// A rejected cache must not leave partially read components behind.
+			return bLoaded || Cache.Components.Num() != 0;
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSceneCacheRoundTripTest, "MicrosoftOpenXR.SceneCache.RoundTrip",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FSceneCacheRoundTripTest::RunTest(const FString& Parameters)
+	{
+		FSceneCache Cache;
+		Cache.WorldToMetersScale = 100.0f;
+		Cache.Components.Add(MakeComponent(1, true, MakeGridMesh(8)));
+		Cache.Components.Add(MakeComponent(2, false, nullptr));
+		// A mesh that was never submitted is stored without one.
+		Cache.Components.Add(MakeComponent(3, true, nullptr));
+		Cache.Components.Add(MakeComponent(4, true, MakeGridMesh(1)));
+
+		const FString Path = GetTestCachePath(TEXT("RoundTrip"));
+		TestTrue(TEXT("The cache is saved"), SaveSceneCache(Path, Cache));
+
+		FSceneCache Loaded;
+		if (!TestTrue(TEXT("The cache is loaded"), LoadSceneCache(Path, Loaded)))
+		{
+			return false;
+		}
+
+		TestEqual(TEXT("WorldToMetersScale"), Loaded.WorldToMetersScale, Cache.WorldToMetersScale);
+		if (!TestEqual(TEXT("Component count"), Loaded.Components.Num(), Cache.Components.Num()))
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < Cache.Components.Num(); ++Index)
+		{
+			const FSceneCacheComponent& Expected = Cache.Components[Index];
+			const FSceneCacheComponent& Actual = Loaded.Components[Index];
+			const bool bHasMesh = Expected.MeshGuid.IsValid() && Expected.MeshData.IsValid();
+
+			TestTrue(TEXT("Uuid"), FMemory::Memcmp(Expected.Uuid.bytes, Actual.Uuid.bytes, sizeof(Actual.Uuid.bytes)) == 0);
+			TestEqual(TEXT("MeshGuid"), Actual.MeshGuid, bHasMesh ? Expected.MeshGuid : FGuid());
+			TestTrue(TEXT("Orientation"),
+				FMemory::Memcmp(&Expected.PoseInAnchorSpace.orientation, &Actual.PoseInAnchorSpace.orientation, sizeof(XrQuaternionf)) == 0);
+			TestTrue(TEXT("Position"),
+				FMemory::Memcmp(&Expected.PoseInAnchorSpace.position, &Actual.PoseInAnchorSpace.position, sizeof(XrVector3f)) == 0);
+			TestTrue(TEXT("Type"), Actual.Type == Expected.Type);
+			TestEqual(TEXT("Extent"), Actual.Extent, Expected.Extent);
+			TestEqual(TEXT("PlaneHash"), Actual.PlaneHash, Expected.PlaneHash);
+			TestEqual(TEXT("MeshHash"), Actual.MeshHash, bHasMesh ? Expected.MeshHash : 0ull);
+
+			if (!bHasMesh)
+			{
+				TestFalse(TEXT("A component without a mesh loads without one"), Actual.MeshData.IsValid());
+				continue;
+			}
+			if (TestTrue(TEXT("Mesh data"), Actual.MeshData.IsValid()))
+			{
+				TestTrue(TEXT("Vertices"), Actual.MeshData->GetVertices() == Expected.MeshData->GetVertices());
+				TestTrue(TEXT("Indices"), Actual.MeshData->GetIndices() == Expected.MeshData->GetIndices());
+			}
+		}
+
+		FSceneCache Empty;
+		FSceneCache LoadedEmpty;
+		const FString EmptyPath = GetTestCachePath(TEXT("Empty"));
+		TestTrue(TEXT("An empty cache round trips"), SaveSceneCache(EmptyPath, Empty) && LoadSceneCache(EmptyPath, LoadedEmpty));
+		TestEqual(TEXT("An empty cache has no components"), LoadedEmpty.Components.Num(), 0);
+
+		IFileManager::Get().Delete(*Path);
+		IFileManager::Get().Delete(*EmptyPath);
+		return true;
+	}
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSceneCacheRejectsCorruptFilesTest, "MicrosoftOpenXR.SceneCache.RejectsCorruptFiles",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FSceneCacheRejectsCorruptFilesTest::RunTest(const FString& Parameters)
+	{
+		FSceneCache Cache;
+		Cache.Components.Add(MakeComponent(1, true, MakeGridMesh(8)));
+		Cache.Components.Add(MakeComponent(2, false, nullptr));
+
+		const FString Path = GetTestCachePath(TEXT("Valid"));
+		TArray<uint8> File;
+		if (!TestTrue(TEXT("The cache is saved"), SaveSceneCache(Path, Cache) && FFileHelper::LoadFileToArray(File, *Path)))
+		{
+			return false;
+		}
+
+		const FString PatchedPath = GetTestCachePath(TEXT("Corrupt"));
+		const uint64 DataOffset = ReadAt<uint64>(File, HeaderDataOffsetOffset);
+		const uint64 DataSize = ReadAt<uint64>(File, HeaderDataSizeOffset);
+
+		TestFalse(TEXT("An empty file is rejected"), LoadsModifiedCache(TArray<uint8>(), PatchedPath));
+		TestFalse(TEXT("A truncated header is rejected"), LoadsModifiedCache(TArray<uint8>(File.GetData(), HeaderSize - 1), PatchedPath));
+		TestFalse(TEXT("Truncated records are rejected"), LoadsModifiedCache(TArray<uint8>(File.GetData(), HeaderSize + 60), PatchedPath));
+		TestFalse(TEXT("Truncated mesh data is rejected"), LoadsModifiedCache(TArray<uint8>(File.GetData(), File.Num() - 1), PatchedPath));
+
+		TArray<uint8> Patched = File;
+		WriteAt<uint32>(Patched, HeaderMagicOffset, 0);
+		TestFalse(TEXT("A bad magic number is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		Patched = File;
+		WriteAt<uint64>(Patched, HeaderDataOffsetOffset, File.Num() + 16);
+		TestFalse(TEXT("A data offset past the end of the file is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		Patched = File;
+		WriteAt<uint64>(Patched, HeaderDataOffsetOffset, HeaderSize);
+		TestFalse(TEXT("A data offset overlapping the records is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		Patched = File;
+		WriteAt<uint64>(Patched, HeaderDataSizeOffset, DataSize + 1);
+		TestFalse(TEXT("A data size past the end of the file is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		Patched = File;
+		WriteAt<uint64>(Patched, HeaderSize + RecordMeshOffsetOffset, DataSize);
+		TestFalse(TEXT("A mesh offset at the end of the data is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		Patched = File;
+		WriteAt<uint64>(Patched, HeaderSize + RecordMeshOffsetOffset, MAX_uint64 - 4);
+		TestFalse(TEXT("An overflowing mesh offset is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		Patched = File;
+		FMemory::Memset(Patched.GetData() + DataOffset, 0xFF, DataSize);
+		TestFalse(TEXT("Corrupt mesh data is rejected"), LoadsModifiedCache(Patched, PatchedPath));
+
+		// Indices are written as given, the loader must check them before collision reads through them.
+		FSceneCache OutOfRange;
+		OutOfRange.Components.Add(MakeComponent(1, true, MakeGridMesh(2, 1)));
+		FSceneCache Loaded;
+		TestTrue(TEXT("A cache with an out of range index is saved"), SaveSceneCache(PatchedPath, OutOfRange));
+		TestFalse(TEXT("An out of range index is rejected"), LoadSceneCache(PatchedPath, Loaded));
+		TestEqual(TEXT("A rejected cache has no components"), Loaded.Components.Num(), 0);
+
+		IFileManager::Get().Delete(*Path);
+		IFileManager::Get().Delete(*PatchedPath);
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,131 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "OpenXRCore.h"
+#include "SceneUnderstandingBase.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		constexpr float Scale = 100.0f;
+
+		XrSceneComponentLocationMSFT MakeLocation(const FVector& Position, XrSpaceLocationFlags Flags)
+		{
+			XrSceneComponentLocationMSFT Location;
+			Location.flags = Flags;
+			Location.pose = {{0.0f, 0.0f, 0.0f, 1.0f}, ToXrVector(Position, Scale)};
+			return Location;
+		}
+
+		bool XrVectorEquals(const XrVector3f& A, const XrVector3f& B)
+		{
+			return FMath::IsNearlyEqual(A.x, B.x, KINDA_SMALL_NUMBER) && FMath::IsNearlyEqual(A.y, B.y, KINDA_SMALL_NUMBER) &&
+				   FMath::IsNearlyEqual(A.z, B.z, KINDA_SMALL_NUMBER);
+		}
+
+		bool IsIdentityOrientation(const XrQuaternionf& Orientation)
+		{
+			return FQuat(Orientation.x, Orientation.y, Orientation.z, Orientation.w).Equals(FQuat::Identity);
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSceneUnderstandingSortByViewTest, "MicrosoftOpenXR.SceneUnderstanding.SortComponentsByView",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FSceneUnderstandingSortByViewTest::RunTest(const FString& Parameters)
+	{
+		constexpr XrSpaceLocationFlags Located = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT;
+
+		// The head is at the origin looking along +X.
+		const TArray<XrSceneComponentLocationMSFT> Locations = {
+			MakeLocation(FVector(100.0f, 0.0f, 0.0f), 0),
+			MakeLocation(FVector(-100.0f, 0.0f, 0.0f), Located),
+			MakeLocation(FVector(300.0f, 0.0f, 0.0f), Located),
+			MakeLocation(FVector(0.0f, -100.0f, 0.0f), Located),
+			MakeLocation(FVector(100.0f, 10.0f, 0.0f), Located),
+			MakeLocation(FVector(100.0f, 0.0f, 0.0f), XR_SPACE_LOCATION_POSITION_VALID_BIT),
+			MakeLocation(FVector(50.0f, 0.0f, 0.0f), Located),
+		};
+
+		// The nearest component in view is left out, only the given indices are ordered.
+		TArray<int32> Indices = {0, 1, 2, 3, 4, 5};
+		TArray<TPair<float, int32>> Scratch;
+		SortComponentsByView(Indices, Locations, FVector::ZeroVector, FVector::ForwardVector, Scale, Scratch);
+
+		// Near and in view, far and in view, then the components out of view at the same distance in their original order,
+		// then the components without a valid pose in their original order.
+		const TArray<int32> Expected = {4, 2, 1, 3, 0, 5};
+		TestEqual(TEXT("Number of sorted indices"), Indices.Num(), Expected.Num());
+		for (int32 Index = 0; Index < FMath::Min(Indices.Num(), Expected.Num()); ++Index)
+		{
+			TestEqual(*FString::Printf(TEXT("Sorted index %d"), Index), Indices[Index], Expected[Index]);
+		}
+
+		TArray<int32> Empty;
+		SortComponentsByView(Empty, Locations, FVector::ZeroVector, FVector::ForwardVector, Scale, Scratch);
+		TestEqual(TEXT("Sorting no indices"), Empty.Num(), 0);
+
+		return true;
+	}
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSceneUnderstandingBoundsTest, "MicrosoftOpenXR.SceneUnderstanding.ConvertSceneBounds",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FSceneUnderstandingBoundsTest::RunTest(const FString& Parameters)
+	{
+		// World space is one meter behind tracking space.
+		const FTransform WorldToTracking(FVector(100.0f, 0.0f, 0.0f));
+
+		const TArray<FSphere> Spheres = {FSphere(FVector(100.0f, 0.0f, 0.0f), 50.0f)};
+		const TArray<FBoxBound> Boxes = {
+			{FTransform(FQuat::Identity, FVector(0.0f, 0.0f, 50.0f), FVector(1.0f, 2.0f, 1.0f)), FVector(10.0f, 20.0f, 30.0f)}};
+		const TArray<FFrustumBound> Frustums = {{FTransform::Identity, 90.0f, 60.0f, 500.0f}};
+
+		TArray<XrSceneSphereBoundMSFT> OutSpheres;
+		TArray<XrSceneOrientedBoxBoundMSFT> OutBoxes;
+		TArray<XrSceneFrustumBoundMSFT> OutFrustums;
+		ConvertSceneBounds(Spheres, Boxes, Frustums, WorldToTracking, Scale, OutSpheres, OutBoxes, OutFrustums);
+
+		if (!TestEqual(TEXT("Number of spheres"), OutSpheres.Num(), 1) || !TestEqual(TEXT("Number of boxes"), OutBoxes.Num(), 1) ||
+			!TestEqual(TEXT("Number of frustums"), OutFrustums.Num(), 1))
+		{
+			return false;
+		}
+
+		// Unreal's X, Y and Z map to OpenXR's -z, x and y, in meters.
+		TestTrue(TEXT("Sphere center in tracking space"), XrVectorEquals(OutSpheres[0].center, {0.0f, 0.0f, -2.0f}));
+		TestEqual(TEXT("Sphere radius in meters"), OutSpheres[0].radius, 0.5f, KINDA_SMALL_NUMBER);
+
+		TestTrue(TEXT("Box center in tracking space"), XrVectorEquals(OutBoxes[0].pose.position, {0.0f, 0.5f, -1.0f}));
+		TestTrue(TEXT("Box orientation"), IsIdentityOrientation(OutBoxes[0].pose.orientation));
+		TestTrue(TEXT("Box size is the scaled extent, edge to edge"), XrVectorEquals(OutBoxes[0].extents, {0.8f, 0.6f, 0.2f}));
+
+		const XrFovf& Fov = OutFrustums[0].fov;
+		TestTrue(TEXT("Frustum origin in tracking space"), XrVectorEquals(OutFrustums[0].pose.position, {0.0f, 0.0f, -1.0f}));
+		TestTrue(TEXT("Frustum orientation"), IsIdentityOrientation(OutFrustums[0].pose.orientation));
+		TestEqual(TEXT("Frustum left angle"), Fov.angleLeft, -PI / 4.0f, KINDA_SMALL_NUMBER);
+		TestEqual(TEXT("Frustum right angle"), Fov.angleRight, PI / 4.0f, KINDA_SMALL_NUMBER);
+		TestEqual(TEXT("Frustum up angle"), Fov.angleUp, PI / 6.0f, KINDA_SMALL_NUMBER);
+		TestEqual(TEXT("Frustum down angle"), Fov.angleDown, -PI / 6.0f, KINDA_SMALL_NUMBER);
+		TestEqual(TEXT("Frustum far distance in meters"), OutFrustums[0].farDistance, 5.0f, KINDA_SMALL_NUMBER);
+
+		// A scaled world, such as from an AR alignment, scales the bounds with it.  The outputs are appended to.
+		const FTransform ScaledWorldToTracking(FQuat::Identity, FVector::ZeroVector, FVector(2.0f));
+		ConvertSceneBounds({FSphere(FVector(10.0f, 0.0f, 0.0f), 50.0f)}, {}, {}, ScaledWorldToTracking, Scale, OutSpheres, OutBoxes,
+			OutFrustums);
+		if (TestEqual(TEXT("Number of spheres after a second conversion"), OutSpheres.Num(), 2))
+		{
+			TestTrue(TEXT("Scaled sphere center"), XrVectorEquals(OutSpheres[1].center, {0.0f, 0.0f, -0.2f}));
+			TestEqual(TEXT("Scaled sphere radius"), OutSpheres[1].radius, 1.0f, KINDA_SMALL_NUMBER);
+		}
+
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,261 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "TrackedGeometryCollision.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		constexpr float GridSpacing = 10.0f;
+		constexpr float LayerSpacing = 50.0f;
+		constexpr int32 LayerCount = 3;
+
+		// Stacked, uneven grids with their triangles shuffled, so a segment usually crosses several layers
+		// and the first triangle found in index order is rarely the closest one.
+		FTrackedMeshDataRef MakeLayeredMesh(int32 GridSize, FRandomStream& Random)
+		{
+			TArray<FVector> Vertices;
+			TArray<MRMESH_INDEX_TYPE> Indices;
+			for (int32 Layer = 0; Layer < LayerCount; ++Layer)
+			{
+				const int32 FirstVertex = Vertices.Num();
+				for (int32 Y = 0; Y <= GridSize; ++Y)
+				{
+					for (int32 X = 0; X <= GridSize; ++X)
+					{
+						const float Height = Layer * LayerSpacing + 5.0f * FMath::Sin(X * 0.7f + Layer) * FMath::Cos(Y * 0.3f);
+						Vertices.Add(FVector(X * GridSpacing, Y * GridSpacing, Height));
+					}
+				}
+				for (int32 Y = 0; Y < GridSize; ++Y)
+				{
+					for (int32 X = 0; X < GridSize; ++X)
+					{
+						const MRMESH_INDEX_TYPE Corner = FirstVertex + Y * (GridSize + 1) + X;
+						const MRMESH_INDEX_TYPE Right = Corner + 1;
+						const MRMESH_INDEX_TYPE Up = Corner + GridSize + 1;
+						const MRMESH_INDEX_TYPE UpRight = Up + 1;
+						Indices.Append({Corner, Right, Up, Right, UpRight, Up});
+					}
+				}
+			}
+
+			const int32 TriangleCount = Indices.Num() / 3;
+			for (int32 Triangle = TriangleCount - 1; Triangle > 0; --Triangle)
+			{
+				const int32 Other = Random.RandRange(0, Triangle);
+				for (int32 Corner = 0; Corner < 3; ++Corner)
+				{
+					Swap(Indices[Triangle * 3 + Corner], Indices[Other * 3 + Corner]);
+				}
+			}
+
+			return MakeTrackedMeshData(MoveTemp(Vertices), MoveTemp(Indices));
+		}
+
+		struct FSegment
+		{
+			FVector Start;
+			FVector End;
+		};
+
+		// Mostly steep segments through every layer, some shallow ones that cross few triangles or miss the mesh.
+		TArray<FSegment> MakeSegments(int32 GridSize, int32 Count, const FTransform& MeshToWorld, FRandomStream& Random)
+		{
+			const float Size = GridSize * GridSpacing;
+			TArray<FSegment> Segments;
+			Segments.Reserve(Count);
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				const FVector Start(Random.FRandRange(-0.1f, 1.1f) * Size, Random.FRandRange(-0.1f, 1.1f) * Size, LayerCount * LayerSpacing + 50.0f);
+				const FVector End = Index % 4 == 0
+					? FVector(Random.FRandRange(-0.1f, 1.1f) * Size, Random.FRandRange(-0.1f, 1.1f) * Size, Random.FRandRange(-50.0f, 100.0f))
+					: Start + FVector(Random.FRandRange(-50.0f, 50.0f), Random.FRandRange(-50.0f, 50.0f), -(LayerCount + 1) * LayerSpacing - 50.0f);
+				Segments.Add({MeshToWorld.TransformPosition(Start), MeshToWorld.TransformPosition(End)});
+			}
+			return Segments;
+		}
+
+		// The collision test before the bounding volume hierarchy: every triangle transformed to world space, stopping at the first hit.
+		bool LinearScanFirstHit(const FTrackedMeshData& Mesh, const FSegment& Segment, const FTransform& MeshToWorld, float& OutHitDistance)
+		{
+			const TArray<FVector>& Vertices = Mesh.GetVertices();
+			const TArray<MRMESH_INDEX_TYPE>& Indices = Mesh.GetIndices();
+			for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+			{
+				FVector HitPoint, HitNormal;
+				if (FMath::SegmentTriangleIntersection(Segment.Start, Segment.End, MeshToWorld.TransformPosition(Vertices[Indices[Index]]),
+						MeshToWorld.TransformPosition(Vertices[Indices[Index + 1]]), MeshToWorld.TransformPosition(Vertices[Indices[Index + 2]]),
+						HitPoint, HitNormal))
+				{
+					OutHitDistance = (HitPoint - Segment.Start).Size();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Reference closest hit: every triangle tested, keeping the nearest.
+		bool BruteForceClosestHit(const FTrackedMeshData& Mesh, const FSegment& Segment, const FTransform& MeshToWorld, float& OutHitDistance)
+		{
+			const TArray<FVector>& Vertices = Mesh.GetVertices();
+			const TArray<MRMESH_INDEX_TYPE>& Indices = Mesh.GetIndices();
+			bool bHit = false;
+			OutHitDistance = MAX_flt;
+			for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+			{
+				FVector HitPoint, HitNormal;
+				if (FMath::SegmentTriangleIntersection(Segment.Start, Segment.End, MeshToWorld.TransformPosition(Vertices[Indices[Index]]),
+						MeshToWorld.TransformPosition(Vertices[Indices[Index + 1]]), MeshToWorld.TransformPosition(Vertices[Indices[Index + 2]]),
+						HitPoint, HitNormal))
+				{
+					OutHitDistance = FMath::Min(OutHitDistance, (HitPoint - Segment.Start).Size());
+					bHit = true;
+				}
+			}
+			return bHit;
+		}
+
+		const FTransform& GetTestMeshToWorld()
+		{
+			static const FTransform MeshToWorld(FRotator(10.0f, 30.0f, 5.0f), FVector(100.0f, -200.0f, 50.0f), FVector(1.5f));
+			return MeshToWorld;
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackedGeometryCollisionClosestHitTest, "MicrosoftOpenXR.TrackedGeometryCollision.ClosestHit",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FTrackedGeometryCollisionClosestHitTest::RunTest(const FString& Parameters)
+	{
+		constexpr int32 GridSize = 16;
+		constexpr int32 SegmentCount = 2000;
+		// Hits are found in mesh space by Collides and in world space by the references.
+		constexpr float DistanceTolerance = 0.05f;
+
+		FRandomStream Random(1234);
+		const FTransform& MeshToWorld = GetTestMeshToWorld();
+		const FTrackedMeshDataRef Mesh = MakeLayeredMesh(GridSize, Random);
+		const TrackedGeometryCollision Collision(Mesh);
+		const TArray<FSegment> Segments = MakeSegments(GridSize, SegmentCount, MeshToWorld, Random);
+
+		int32 Hits = 0;
+		int32 Mismatches = 0;
+		int32 FirstHitsNotClosest = 0;
+		for (const FSegment& Segment : Segments)
+		{
+			FVector HitPoint, HitNormal;
+			float HitDistance = 0.0f;
+			const bool bHit = Collision.Collides(Segment.Start, Segment.End, MeshToWorld, HitPoint, HitNormal, HitDistance, ECollisionQuery::ClosestHit);
+
+			float ExpectedDistance = 0.0f;
+			const bool bExpectedHit = BruteForceClosestHit(*Mesh, Segment, MeshToWorld, ExpectedDistance);
+
+			// The two intersection tests can disagree on segments that graze a triangle edge, allow a few.
+			if (bHit != bExpectedHit || (bHit && !FMath::IsNearlyEqual(HitDistance, ExpectedDistance, DistanceTolerance)))
+			{
+				++Mismatches;
+				continue;
+			}
+			if (!bHit)
+			{
+				continue;
+			}
+			++Hits;
+
+			TestTrue(TEXT("The hit point is on the segment at the hit distance"),
+				HitPoint.Equals(Segment.Start + (Segment.End - Segment.Start).GetSafeNormal() * HitDistance, DistanceTolerance * 2.0f));
+			TestTrue(TEXT("The hit normal is normalized"), HitNormal.IsNormalized());
+
+			FVector AnyHitPoint, AnyHitNormal;
+			float AnyHitDistance = 0.0f;
+			TestTrue(TEXT("Any hit finds a hit when closest hit does"),
+				Collision.Collides(Segment.Start, Segment.End, MeshToWorld, AnyHitPoint, AnyHitNormal, AnyHitDistance, ECollisionQuery::AnyHit));
+			TestTrue(TEXT("Any hit is never closer than the closest hit"), AnyHitDistance >= HitDistance - DistanceTolerance);
+
+			float FirstHitDistance = 0.0f;
+			if (LinearScanFirstHit(*Mesh, Segment, MeshToWorld, FirstHitDistance) && FirstHitDistance > HitDistance + DistanceTolerance)
+			{
+				++FirstHitsNotClosest;
+			}
+		}
+
+		AddInfo(FString::Printf(TEXT("%d of %d segments hit, %d disagreed with the brute force closest hit, ")
+								TEXT("the old linear scan returned a further hit for %d."),
+			Hits, SegmentCount, Mismatches, FirstHitsNotClosest));
+		TestTrue(TEXT("A large share of the segments hit the mesh"), Hits > SegmentCount / 3);
+		TestTrue(TEXT("Closest hit matches brute force"), Mismatches <= SegmentCount / 200);
+		// Otherwise this mesh would not tell the closest hit from the first one.
+		TestTrue(TEXT("The first hit in index order is often not the closest"), FirstHitsNotClosest > Hits / 4);
+
+		FVector HitPoint, HitNormal;
+		float HitDistance;
+		const FVector Above = MeshToWorld.TransformPosition(FVector(GridSize * GridSpacing * 0.5f, GridSize * GridSpacing * 0.5f, 1000.0f));
+		const FVector FurtherAbove = MeshToWorld.TransformPosition(FVector(GridSize * GridSpacing * 0.5f, GridSize * GridSpacing * 0.5f, 2000.0f));
+		TestFalse(TEXT("A segment that ends before the mesh misses"), Collision.Collides(FurtherAbove, Above, MeshToWorld, HitPoint, HitNormal, HitDistance));
+		const FTransform Hidden(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+		TestFalse(TEXT("A mesh scaled to zero is never hit"), Collision.Collides(Above, -Above, Hidden, HitPoint, HitNormal, HitDistance));
+
+		return true;
+	}
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackedGeometryCollisionPerformanceTest, "MicrosoftOpenXR.TrackedGeometryCollision.Performance",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+	bool FTrackedGeometryCollisionPerformanceTest::RunTest(const FString& Parameters)
+	{
+		constexpr int32 SegmentCount = 1000;
+
+		FRandomStream Random(5678);
+		const FTransform& MeshToWorld = GetTestMeshToWorld();
+		// Roughly a small plane, a room scale spatial mapping mesh, and a large scene understanding mesh.
+		for (const int32 GridSize : {8, 32, 96})
+		{
+			const FTrackedMeshDataRef Mesh = MakeLayeredMesh(GridSize, Random);
+			const TArray<FSegment> Segments = MakeSegments(GridSize, SegmentCount, MeshToWorld, Random);
+
+			double StartTime = FPlatformTime::Seconds();
+			const TrackedGeometryCollision Collision(Mesh);
+			const double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+			// Counting hits keeps the loops from being optimized away and shows the methods agree on what was hit.
+			auto Time = [&Segments](int32& OutHits, TFunctionRef<bool(const FSegment&)> Trace) {
+				OutHits = 0;
+				const double LoopStartTime = FPlatformTime::Seconds();
+				for (const FSegment& Segment : Segments)
+				{
+					OutHits += Trace(Segment) ? 1 : 0;
+				}
+				return (FPlatformTime::Seconds() - LoopStartTime) * 1000.0 / Segments.Num();
+			};
+
+			FVector HitPoint, HitNormal;
+			float HitDistance;
+			int32 ClosestHits, AnyHits, LinearHits;
+			const double ClosestTime = Time(ClosestHits, [&](const FSegment& Segment) {
+				return Collision.Collides(Segment.Start, Segment.End, MeshToWorld, HitPoint, HitNormal, HitDistance, ECollisionQuery::ClosestHit);
+			});
+			const double AnyTime = Time(AnyHits, [&](const FSegment& Segment) {
+				return Collision.Collides(Segment.Start, Segment.End, MeshToWorld, HitPoint, HitNormal, HitDistance, ECollisionQuery::AnyHit);
+			});
+			const double LinearTime = Time(LinearHits, [&](const FSegment& Segment) {
+				return LinearScanFirstHit(*Mesh, Segment, MeshToWorld, HitDistance);
+			});
+
+			AddInfo(FString::Printf(TEXT("%d triangles: build %.3f ms, closest hit %.4f ms, any hit %.4f ms, old linear scan %.4f ms per segment ")
+									TEXT("(%d, %d and %d hits)."),
+				Mesh->GetIndices().Num() / 3, BuildTime * 1000.0, ClosestTime, AnyTime, LinearTime, ClosestHits, AnyHits, LinearHits));
+			TestEqual(TEXT("Closest and any hit agree on which segments hit"), AnyHits, ClosestHits);
+		}
+
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
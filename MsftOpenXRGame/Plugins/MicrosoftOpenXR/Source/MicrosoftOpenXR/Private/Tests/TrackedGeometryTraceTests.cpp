@@ -0,0 +1,360 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "Algo/Count.h"
+#include "ARTrackable.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "TrackedGeometryTrace.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		constexpr float TileSize = 100.0f;
+		constexpr int32 TilesPerSide = 4;
+		constexpr int32 LayerCount = 3;
+		constexpr int32 PlaneCount = 12;
+		constexpr float RoomSize = TileSize * TilesPerSide;
+		constexpr float RoomHeight = TileSize * LayerCount;
+
+		// Floor, table and ceiling height layers of tilted, wavy mesh tiles, with planes scattered through the room,
+		// in a tracking space that is moved and scaled away from world space.
+		class FTestTraceScene
+		{
+		public:
+			explicit FTestTraceScene(FRandomStream& Random)
+			{
+				MeshSpatialIndex.Reset(200.0f);
+				PlaneSpatialIndex.Reset(200.0f);
+
+				for (int32 Layer = 0; Layer < LayerCount; ++Layer)
+				{
+					for (int32 Y = 0; Y < TilesPerSide; ++Y)
+					{
+						for (int32 X = 0; X < TilesPerSide; ++X)
+						{
+							const FRotator Tilt(Random.FRandRange(-10.0f, 10.0f), Random.FRandRange(-5.0f, 5.0f), Random.FRandRange(-10.0f, 10.0f));
+							const FTransform LocalToTracking(
+								Tilt, FVector(X * TileSize, Y * TileSize, Layer * TileSize + Random.FRandRange(-10.0f, 10.0f)));
+							AddGeometry(MakeTile(Random), LocalToTracking, MeshCollisionInfo, MeshSpatialIndex);
+						}
+					}
+				}
+
+				for (int32 Index = 0; Index < PlaneCount; ++Index)
+				{
+					const FVector2D Extent(Random.FRandRange(25.0f, 100.0f), Random.FRandRange(25.0f, 100.0f));
+					const FTransform LocalToTracking(
+						FRotator(Random.FRandRange(-90.0f, 90.0f), Random.FRandRange(0.0f, 360.0f), Random.FRandRange(-90.0f, 90.0f)),
+						FVector(Random.FRandRange(0.0f, RoomSize), Random.FRandRange(0.0f, RoomSize), Random.FRandRange(0.0f, RoomHeight)));
+					AddGeometry(MakeQuad(Extent), LocalToTracking, PlaneCollisionInfo, PlaneSpatialIndex);
+				}
+			}
+
+			FTrackedGeometryTraceScene GetTraceScene() const
+			{
+				return FTrackedGeometryTraceScene{MeshCollisionInfo, PlaneCollisionInfo, MeshSpatialIndex, PlaneSpatialIndex, TrackingToWorld};
+			}
+
+			UARTrackedGeometry* FindGeometry(const FGuid& Id, FTransform& OutLocalToWorld) const
+			{
+				const FTestGeometry* Geometry = Geometries.Find(Id);
+				if (Geometry == nullptr)
+				{
+					return nullptr;
+				}
+				OutLocalToWorld = Geometry->LocalToWorld;
+				return Geometry->Object.Get();
+			}
+
+			bool IsPlane(const UARTrackedGeometry* Object) const
+			{
+				for (const auto& Elem : Geometries)
+				{
+					if (Elem.Value.Object.Get() == Object)
+					{
+						return Elem.Value.bPlane;
+					}
+				}
+				return false;
+			}
+
+			// Mostly segments down through every layer, some across the room through the planes, all in world space.
+			TArray<FTrackedGeometryTraceSegment> MakeSegments(int32 Count, FRandomStream& Random) const
+			{
+				auto RandomPoint = [&Random](float MinZ, float MaxZ) {
+					return FVector(Random.FRandRange(-50.0f, RoomSize + 50.0f), Random.FRandRange(-50.0f, RoomSize + 50.0f),
+						Random.FRandRange(MinZ, MaxZ));
+				};
+
+				TArray<FTrackedGeometryTraceSegment> Segments;
+				Segments.Reserve(Count);
+				for (int32 Index = 0; Index < Count; ++Index)
+				{
+					FTrackedGeometryTraceSegment Segment;
+					if (Index % 4 == 0)
+					{
+						const float Z = Random.FRandRange(0.0f, RoomHeight);
+						Segment.Start = FVector(-100.0f, Random.FRandRange(0.0f, RoomSize), Z);
+						Segment.End = FVector(RoomSize + 100.0f, Random.FRandRange(0.0f, RoomSize), Z);
+					}
+					else
+					{
+						Segment.Start = RandomPoint(RoomHeight + 50.0f, RoomHeight + 100.0f);
+						Segment.End = RandomPoint(-100.0f, -50.0f);
+					}
+					Segment.Start = TrackingToWorld.TransformPosition(Segment.Start);
+					Segment.End = TrackingToWorld.TransformPosition(Segment.End);
+					Segments.Add(Segment);
+				}
+				return Segments;
+			}
+
+		private:
+			struct FTestGeometry
+			{
+				TStrongObjectPtr<UARTrackedGeometry> Object;
+				FTransform LocalToWorld;
+				bool bPlane;
+			};
+
+			static TrackedGeometryCollision MakeTile(FRandomStream& Random)
+			{
+				constexpr int32 QuadsPerSide = 8;
+				constexpr float Spacing = TileSize / QuadsPerSide;
+				const float Phase = Random.FRandRange(0.0f, PI);
+
+				TArray<FVector> Vertices;
+				TArray<MRMESH_INDEX_TYPE> Indices;
+				for (int32 Y = 0; Y <= QuadsPerSide; ++Y)
+				{
+					for (int32 X = 0; X <= QuadsPerSide; ++X)
+					{
+						Vertices.Add(FVector(X * Spacing, Y * Spacing, 5.0f * FMath::Sin(X * 0.7f + Phase) * FMath::Cos(Y * 0.5f)));
+					}
+				}
+				for (int32 Y = 0; Y < QuadsPerSide; ++Y)
+				{
+					for (int32 X = 0; X < QuadsPerSide; ++X)
+					{
+						const MRMESH_INDEX_TYPE Corner = Y * (QuadsPerSide + 1) + X;
+						const MRMESH_INDEX_TYPE Right = Corner + 1;
+						const MRMESH_INDEX_TYPE Up = Corner + QuadsPerSide + 1;
+						const MRMESH_INDEX_TYPE UpRight = Up + 1;
+						Indices.Append({Corner, Right, Up, Right, UpRight, Up});
+					}
+				}
+				return TrackedGeometryCollision(MoveTemp(Vertices), MoveTemp(Indices));
+			}
+
+			static TrackedGeometryCollision MakeQuad(const FVector2D& Extent)
+			{
+				TArray<FVector> Vertices = {FVector(-Extent.X, -Extent.Y, 0.0f), FVector(Extent.X, -Extent.Y, 0.0f),
+					FVector(-Extent.X, Extent.Y, 0.0f), FVector(Extent.X, Extent.Y, 0.0f)};
+				TArray<MRMESH_INDEX_TYPE> Indices = {0, 1, 2, 1, 3, 2};
+				return TrackedGeometryCollision(MoveTemp(Vertices), MoveTemp(Indices));
+			}
+
+			void AddGeometry(TrackedGeometryCollision&& Collision, const FTransform& LocalToTracking,
+				TMap<FGuid, TrackedGeometryCollision>& CollisionInfo, FTrackedGeometrySpatialIndex& SpatialIndex)
+			{
+				const FGuid Id = FGuid::NewGuid();
+				SpatialIndex.Update(Id, Collision.GetBoundingBox().TransformBy(LocalToTracking));
+				CollisionInfo.Add(Id, MoveTemp(Collision));
+				Geometries.Add(Id, FTestGeometry{TStrongObjectPtr<UARTrackedGeometry>(NewObject<UARTrackedGeometry>()), LocalToTracking * TrackingToWorld,
+									   &CollisionInfo == &PlaneCollisionInfo});
+			}
+
+			const FTransform TrackingToWorld = FTransform(FRotator(0.0f, 40.0f, 0.0f), FVector(300.0f, -150.0f, 20.0f), FVector(1.25f));
+			TMap<FGuid, TrackedGeometryCollision> MeshCollisionInfo;
+			TMap<FGuid, TrackedGeometryCollision> PlaneCollisionInfo;
+			FTrackedGeometrySpatialIndex MeshSpatialIndex;
+			FTrackedGeometrySpatialIndex PlaneSpatialIndex;
+			TMap<FGuid, FTestGeometry> Geometries;
+		};
+
+		// The closest of a segment's hits from the per-segment trace, the way a caller of LineTraceTrackedObjects picks one.
+		const FARTraceResult* FindClosestHit(const TArray<FARTraceResult>& Hits)
+		{
+			const FARTraceResult* Closest = nullptr;
+			for (const FARTraceResult& Hit : Hits)
+			{
+				if (Closest == nullptr || Hit.GetDistanceFromCamera() < Closest->GetDistanceFromCamera())
+				{
+					Closest = &Hit;
+				}
+			}
+			return Closest;
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackedGeometryTraceBatchedTest, "MicrosoftOpenXR.TrackedGeometryTrace.BatchedMatchesPerSegment",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FTrackedGeometryTraceBatchedTest::RunTest(const FString& Parameters)
+	{
+		constexpr int32 SegmentCount = 2000;
+
+		FRandomStream Random(2468);
+		const FTestTraceScene TestScene(Random);
+		const FTrackedGeometryTraceScene Scene = TestScene.GetTraceScene();
+		auto FindGeometry = [&TestScene](const FGuid& Id, FTransform& OutLocalToWorld) { return TestScene.FindGeometry(Id, OutLocalToWorld); };
+		const TArray<FTrackedGeometryTraceSegment> Segments = TestScene.MakeSegments(SegmentCount, Random);
+
+		for (const bool bTracePlanes : {true, false})
+		{
+			const EARLineTraceChannels TraceChannels = bTracePlanes ? EARLineTraceChannels::PlaneUsingExtent : EARLineTraceChannels::None;
+
+			TArray<FTrackedGeometryTraceResult> Results;
+			Results.SetNum(SegmentCount);
+			LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segments, bTracePlanes, true, Results);
+
+			TArray<FTrackedGeometryTraceResult> SingleThreadedResults;
+			SingleThreadedResults.SetNum(SegmentCount);
+			LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segments, bTracePlanes, false, SingleThreadedResults);
+
+			int32 Hits = 0;
+			int32 PlaneHits = 0;
+			int32 Mismatches = 0;
+			int32 WrongChannels = 0;
+			for (int32 Index = 0; Index < SegmentCount; ++Index)
+			{
+				const TArray<FARTraceResult> SegmentHits =
+					LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segments[Index].Start, Segments[Index].End, TraceChannels);
+				const FARTraceResult* Closest = FindClosestHit(SegmentHits);
+				const FTrackedGeometryTraceResult& Result = Results[Index];
+
+				// Both paths run the same collision test with the same transforms, so the distances match exactly.
+				const bool bMatches = Result.bHit == (Closest != nullptr) &&
+					(!Result.bHit ||
+						(Result.Hit.GetDistanceFromCamera() == Closest->GetDistanceFromCamera() &&
+							SegmentHits.ContainsByPredicate([&Result](const FARTraceResult& Hit) {
+								return Hit.GetTrackedGeometry() == Result.Hit.GetTrackedGeometry() &&
+									Hit.GetDistanceFromCamera() == Result.Hit.GetDistanceFromCamera() &&
+									Hit.GetTraceChannel() == Result.Hit.GetTraceChannel();
+							})));
+				Mismatches += bMatches ? 0 : 1;
+				Hits += Result.bHit ? 1 : 0;
+
+				if (Result.bHit)
+				{
+					// Plane hits are reported on the plane extent channel, mesh hits on none of the requested channels.
+					const bool bPlaneHit = TestScene.IsPlane(Result.Hit.GetTrackedGeometry());
+					PlaneHits += bPlaneHit ? 1 : 0;
+					const EARLineTraceChannels ExpectedChannel = bPlaneHit ? EARLineTraceChannels::PlaneUsingExtent : EARLineTraceChannels::None;
+					WrongChannels += Result.Hit.GetTraceChannel() == ExpectedChannel ? 0 : 1;
+				}
+
+				const FTrackedGeometryTraceResult& SingleThreadedResult = SingleThreadedResults[Index];
+				if (SingleThreadedResult.bHit != Result.bHit ||
+					(Result.bHit && (SingleThreadedResult.Hit.GetDistanceFromCamera() != Result.Hit.GetDistanceFromCamera() ||
+										SingleThreadedResult.Hit.GetTrackedGeometry() != Result.Hit.GetTrackedGeometry() ||
+										SingleThreadedResult.Hit.GetTraceChannel() != Result.Hit.GetTraceChannel())))
+				{
+					AddError(FString::Printf(TEXT("Segment %d differs between the multithreaded and single threaded batched traces."), Index));
+				}
+			}
+
+			AddInfo(FString::Printf(TEXT("%s planes: %d of %d segments hit, %d of them a plane."), bTracePlanes ? TEXT("With") : TEXT("Without"),
+				Hits, SegmentCount, PlaneHits));
+			TestEqual(TEXT("The batched trace finds the closest per-segment hit, with its channel, for every segment"), Mismatches, 0);
+			TestEqual(TEXT("Every hit reports the channel of the geometry it hit"), WrongChannels, 0);
+			if (bTracePlanes)
+			{
+				TestTrue(TEXT("Some segments hit a plane first"), PlaneHits > 0);
+			}
+			else
+			{
+				TestEqual(TEXT("Planes are not hit when they are not traced"), PlaneHits, 0);
+			}
+			TestTrue(TEXT("Most segments hit the scene"), Hits > SegmentCount / 3);
+		}
+
+		// A result is only replaced by a closer hit, so traces into the same results keep the closest across them.
+		TArray<FTrackedGeometryTraceResult> Results;
+		Results.SetNum(SegmentCount);
+		LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segments, true, true, Results);
+		TArray<FTrackedGeometryTraceResult> SeededResults;
+		SeededResults.SetNum(SegmentCount);
+		for (int32 Index = 0; Index < SegmentCount; ++Index)
+		{
+			if (Index % 2 == 0 && Results[Index].bHit)
+			{
+				SeededResults[Index].bHit = true;
+				SeededResults[Index].Hit = FARTraceResult(nullptr, Results[Index].Hit.GetDistanceFromCamera() * 0.5f,
+					EARLineTraceChannels::None, FTransform::Identity, nullptr);
+			}
+		}
+		LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segments, true, true, SeededResults);
+		for (int32 Index = 0; Index < SegmentCount; ++Index)
+		{
+			UARTrackedGeometry* ExpectedGeometry = Index % 2 == 0 ? nullptr : Results[Index].Hit.GetTrackedGeometry();
+			if (Results[Index].bHit != SeededResults[Index].bHit || (Results[Index].bHit && SeededResults[Index].Hit.GetTrackedGeometry() != ExpectedGeometry))
+			{
+				AddError(FString::Printf(TEXT("Segment %d did not keep the closer of the existing and traced hits."), Index));
+			}
+		}
+
+		return true;
+	}
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackedGeometryTracePerformanceTest, "MicrosoftOpenXR.TrackedGeometryTrace.Performance",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+	bool FTrackedGeometryTracePerformanceTest::RunTest(const FString& Parameters)
+	{
+		FRandomStream Random(1357);
+		const FTestTraceScene TestScene(Random);
+		const FTrackedGeometryTraceScene Scene = TestScene.GetTraceScene();
+		auto FindGeometry = [&TestScene](const FGuid& Id, FTransform& OutLocalToWorld) { return TestScene.FindGeometry(Id, OutLocalToWorld); };
+
+		// A few gameplay traces, a sweep of traces for an effect, and a dense batch like a depth probe.
+		for (const int32 SegmentCount : {16, 512, 8192})
+		{
+			const TArray<FTrackedGeometryTraceSegment> Segments = TestScene.MakeSegments(SegmentCount, Random);
+
+			// Counting hits keeps the traces from being optimized away and shows the paths agree on what was hit.
+			auto Time = [](int32& OutHits, TFunctionRef<void(int32&)> Trace) {
+				const double StartTime = FPlatformTime::Seconds();
+				Trace(OutHits);
+				return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+			};
+			auto TimeBatched = [&](int32& OutHits, bool bMultithreaded) {
+				return Time(OutHits, [&](int32& Hits) {
+					TArray<FTrackedGeometryTraceResult> Results;
+					Results.SetNum(SegmentCount);
+					LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segments, true, bMultithreaded, Results);
+					Hits = Algo::CountIf(Results, [](const FTrackedGeometryTraceResult& Result) { return Result.bHit; });
+				});
+			};
+
+			int32 PerSegmentHits, SingleThreadedHits, MultithreadedHits;
+			const double PerSegmentTime = Time(PerSegmentHits, [&](int32& Hits) {
+				Hits = 0;
+				for (const FTrackedGeometryTraceSegment& Segment : Segments)
+				{
+					const TArray<FARTraceResult> SegmentHits =
+						LineTraceTrackedGeometry(Scene, FindGeometry, nullptr, Segment.Start, Segment.End, EARLineTraceChannels::PlaneUsingExtent);
+					Hits += FindClosestHit(SegmentHits) != nullptr ? 1 : 0;
+				}
+			});
+			const double SingleThreadedTime = TimeBatched(SingleThreadedHits, false);
+			const double MultithreadedTime = TimeBatched(MultithreadedHits, true);
+
+			AddInfo(FString::Printf(TEXT("%d segments: per segment %.3f ms, batched single threaded %.3f ms, batched multithreaded %.3f ms ")
+									TEXT("(%d, %d and %d hits)."),
+				SegmentCount, PerSegmentTime, SingleThreadedTime, MultithreadedTime, PerSegmentHits, SingleThreadedHits, MultithreadedHits));
+			TestEqual(TEXT("The batched trace hits the same segments as the per-segment trace"), SingleThreadedHits, PerSegmentHits);
+			TestEqual(TEXT("The multithreaded trace hits the same segments as the single threaded trace"), MultithreadedHits, SingleThreadedHits);
+		}
+
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
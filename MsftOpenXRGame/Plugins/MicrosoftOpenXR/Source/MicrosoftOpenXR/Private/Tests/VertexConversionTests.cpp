@@ -0,0 +1,95 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "OpenXRCore.h"
+#include "VertexConversion.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		constexpr int32 MaxCount = 9;
+		constexpr float Scale = 100.0f;
+
+		XrVector3f MakeXrVector(int32 Index)
+		{
+			return {0.25f + Index, -1.5f * Index, 3.0f - 0.125f * Index};
+		}
+
+		void ResetOutput(FVector (&Out)[MaxCount + 1])
+		{
+			for (FVector& Vector : Out)
+			{
+				Vector = FVector(-1.0f);
+			}
+		}
+
+		// Checks the converted vectors against the scalar conversion, and that nothing past Count was written.
+		void TestConversion(FAutomationTestBase& Test, const TCHAR* What, const XrVector3f* Expected, const FVector* Out, int32 Count)
+		{
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				if (Out[Index] != ToFVector(Expected[Index], Scale))
+				{
+					Test.AddError(FString::Printf(TEXT("%s: vector %d of %d does not match ToFVector."), What, Index, Count));
+				}
+			}
+			if (Out[Count] != FVector(-1.0f))
+			{
+				Test.AddError(FString::Printf(TEXT("%s: converting %d vectors wrote past the end."), What, Count));
+			}
+		}
+	}	 // namespace
+
+	IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVertexConversionTest, "MicrosoftOpenXR.VertexConversion.MatchesToFVector",
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	bool FVertexConversionTest::RunTest(const FString& Parameters)
+	{
+		// One extra source vector so conversions can start unaligned.
+		XrVector3f Source[MaxCount + 1];
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(Source); ++Index)
+		{
+			Source[Index] = MakeXrVector(Index);
+		}
+
+		XrHandMeshVertexMSFT HandVertices[MaxCount];
+		for (int32 Index = 0; Index < MaxCount; ++Index)
+		{
+			HandVertices[Index].position = Source[Index];
+			HandVertices[Index].normal = {1.0f, 2.0f, 3.0f};
+		}
+
+		for (int32 Count = 0; Count <= MaxCount; ++Count)
+		{
+			FVector Out[MaxCount + 1];
+			for (int32 Offset = 0; Offset <= MaxCount - Count; ++Offset)
+			{
+				ResetOutput(Out);
+				ConvertXrVectorsToFVectors(Source + Offset, Out, Count, Scale);
+				TestConversion(*this, TEXT("Packed"), Source + Offset, Out, Count);
+			}
+
+			// Converting in place reads each block before overwriting it.
+			XrVector3f InPlace[MaxCount + 1];
+			FMemory::Memcpy(InPlace, Source, sizeof(InPlace));
+			InPlace[Count] = {-1.0f, -1.0f, -1.0f};
+			FVector* InPlaceOut = reinterpret_cast<FVector*>(InPlace);
+			ConvertXrVectorsToFVectors(InPlace, InPlaceOut, Count, Scale);
+			// The sentinel was not converted, so it reads back as the same -1 vector.
+			TestConversion(*this, TEXT("In place"), Source, InPlaceOut, Count);
+
+			ResetOutput(Out);
+			ConvertXrVectorsToFVectors(&HandVertices[0].position, sizeof(XrHandMeshVertexMSFT), Out, Count, Scale);
+			TestConversion(*this, TEXT("Strided"), Source, Out, Count);
+		}
+
+		return true;
+	}
+}	 // namespace MicrosoftOpenXR
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
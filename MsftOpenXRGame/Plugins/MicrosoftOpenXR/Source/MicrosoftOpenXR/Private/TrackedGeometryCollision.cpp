@@ -3,22 +3,204 @@
 
 #include "TrackedGeometryCollision.h"
 
+#include <algorithm>
+
 namespace MicrosoftOpenXR
 {
+	namespace
+	{
+		constexpr int32 MaxTrianglesPerLeaf = 4;
+		constexpr int32 MaxTraversalDepth = 64;
+
+		// Intersects the segment Start + T * Dir, T in [0, MaxT], with a triangle from either side.
+		FORCEINLINE bool SegmentTriangleIntersection(const FVector& Start, const FVector& Dir, const FVector& A, const FVector& B,
+			const FVector& C, float MaxT, float& OutT)
+		{
+			const FVector EdgeAB = B - A;
+			const FVector EdgeAC = C - A;
+			const FVector P = FVector::CrossProduct(Dir, EdgeAC);
+			const float Determinant = FVector::DotProduct(EdgeAB, P);
+			if (FMath::Abs(Determinant) < SMALL_NUMBER)
+			{
+				// Segment is parallel to the triangle.
+				return false;
+			}
+
+			const float InvDeterminant = 1.0f / Determinant;
+			const FVector ToStart = Start - A;
+			const float U = FVector::DotProduct(ToStart, P) * InvDeterminant;
+			if (U < 0.0f || U > 1.0f)
+			{
+				return false;
+			}
+
+			const FVector Q = FVector::CrossProduct(ToStart, EdgeAB);
+			const float V = FVector::DotProduct(Dir, Q) * InvDeterminant;
+			if (V < 0.0f || U + V > 1.0f)
+			{
+				return false;
+			}
+
+			const float T = FVector::DotProduct(EdgeAC, Q) * InvDeterminant;
+			if (T < 0.0f || T > MaxT)
+			{
+				return false;
+			}
+
+			OutT = T;
+			return true;
+		}
+
+		// Slab test of the segment Start + T * Dir, T in [0, MaxT], against an axis aligned box.
+		// OutEntryT is where the segment enters the box, zero if it starts inside.
+		FORCEINLINE bool SegmentBoxIntersection(
+			const FVector& Start, const FVector& InvDir, const FVector& Min, const FVector& Max, float MaxT, float& OutEntryT)
+		{
+			float TMin = 0.0f;
+			float TMax = MaxT;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				float T0 = (Min[Axis] - Start[Axis]) * InvDir[Axis];
+				float T1 = (Max[Axis] - Start[Axis]) * InvDir[Axis];
+				if (T0 > T1)
+				{
+					Swap(T0, T1);
+				}
+				// NaN from 0 * inf (segment parallel to and on a slab plane) fails both comparisons and is ignored.
+				TMin = T0 > TMin ? T0 : TMin;
+				TMax = T1 < TMax ? T1 : TMax;
+				if (TMin > TMax)
+				{
+					return false;
+				}
+			}
+			OutEntryT = TMin;
+			return true;
+		}
+	}	 // namespace
+
 	TrackedGeometryCollision::TrackedGeometryCollision(TArray<FVector> InVertices, TArray<MRMESH_INDEX_TYPE> InIndices)
-		: Vertices(std::move(InVertices)), Indices(std::move(InIndices))
+		: TrackedGeometryCollision(MakeTrackedMeshData(MoveTemp(InVertices), MoveTemp(InIndices)))
+	{
+	}
+
+	TrackedGeometryCollision::TrackedGeometryCollision(FTrackedMeshDataRef InMeshData)
+		: MeshData(MoveTemp(InMeshData)), BoundingBox(ForceInit)
 	{
 		// Create a bounding box from the input vertices to reduce the number of full meshes that need to be hit-tested.
+		const TArray<FVector>& Vertices = MeshData->GetVertices();
 		if (Vertices.Num() > 0)
 		{
 			BoundingBox = FBox(&Vertices[0], Vertices.Num());
 		}
+
+		BuildBVH();
+	}
+
+	void TrackedGeometryCollision::BuildBVH()
+	{
+		const TArray<FVector>& Vertices = MeshData->GetVertices();
+		const TArray<MRMESH_INDEX_TYPE>& Indices = MeshData->GetIndices();
+		const int32 VertexCount = Vertices.Num();
+		const int32 TriangleCount = Indices.Num() / 3;
+
+		// Per triangle bounds and centroids, only for triangles with valid indices.
+		TArray<FVector> TriangleMin;
+		TArray<FVector> TriangleMax;
+		TArray<FVector> Centroids;
+		TriangleMin.SetNumUninitialized(TriangleCount);
+		TriangleMax.SetNumUninitialized(TriangleCount);
+		Centroids.SetNumUninitialized(TriangleCount);
+		TriangleOrder.Reset(TriangleCount);
+
+		for (int32 Triangle = 0; Triangle < TriangleCount; ++Triangle)
+		{
+			const int32 I0 = (int32) Indices[Triangle * 3];
+			const int32 I1 = (int32) Indices[Triangle * 3 + 1];
+			const int32 I2 = (int32) Indices[Triangle * 3 + 2];
+
+			// Ignore this triangle if it has indices out of range.
+			if ((uint32) I0 >= (uint32) VertexCount || (uint32) I1 >= (uint32) VertexCount || (uint32) I2 >= (uint32) VertexCount)
+			{
+				continue;
+			}
+
+			const FVector& A = Vertices[I0];
+			const FVector& B = Vertices[I1];
+			const FVector& C = Vertices[I2];
+			TriangleMin[Triangle] = A.ComponentMin(B).ComponentMin(C);
+			TriangleMax[Triangle] = A.ComponentMax(B).ComponentMax(C);
+			Centroids[Triangle] = (A + B + C) / 3.0f;
+			TriangleOrder.Add(Triangle);
+		}
+
+		Nodes.Reset();
+		if (TriangleOrder.Num() == 0)
+		{
+			return;
+		}
+
+		// A binary tree with N leaves has 2N - 1 nodes.
+		Nodes.Reserve(2 * FMath::DivideAndRoundUp(TriangleOrder.Num(), MaxTrianglesPerLeaf));
+		Nodes.AddDefaulted();
+		Nodes[0].FirstIndex = 0;
+		Nodes[0].TriangleCount = TriangleOrder.Num();
+
+		TArray<int32, TInlineAllocator<MaxTraversalDepth>> NodesToSplit;
+		NodesToSplit.Push(0);
+		while (NodesToSplit.Num() > 0)
+		{
+			const int32 NodeIndex = NodesToSplit.Pop(false);
+			const int32 First = Nodes[NodeIndex].FirstIndex;
+			const int32 Count = Nodes[NodeIndex].TriangleCount;
+
+			FVector Min = TriangleMin[TriangleOrder[First]];
+			FVector Max = TriangleMax[TriangleOrder[First]];
+			FVector CentroidMin = Centroids[TriangleOrder[First]];
+			FVector CentroidMax = CentroidMin;
+			for (int32 Index = First + 1; Index < First + Count; ++Index)
+			{
+				const int32 Triangle = TriangleOrder[Index];
+				Min = Min.ComponentMin(TriangleMin[Triangle]);
+				Max = Max.ComponentMax(TriangleMax[Triangle]);
+				CentroidMin = CentroidMin.ComponentMin(Centroids[Triangle]);
+				CentroidMax = CentroidMax.ComponentMax(Centroids[Triangle]);
+			}
+			Nodes[NodeIndex].Min = Min;
+			Nodes[NodeIndex].Max = Max;
+
+			if (Count <= MaxTrianglesPerLeaf)
+			{
+				continue;
+			}
+
+			// Split at the median centroid along the longest axis so both children are balanced.
+			const FVector CentroidExtent = CentroidMax - CentroidMin;
+			const int32 Axis = CentroidExtent.X >= CentroidExtent.Y ? (CentroidExtent.X >= CentroidExtent.Z ? 0 : 2)
+																	: (CentroidExtent.Y >= CentroidExtent.Z ? 1 : 2);
+			const int32 Half = Count / 2;
+			int32* Begin = TriangleOrder.GetData() + First;
+			std::nth_element(Begin, Begin + Half, Begin + Count,
+				[&Centroids, Axis](int32 Lhs, int32 Rhs) { return Centroids[Lhs][Axis] < Centroids[Rhs][Axis]; });
+
+			const int32 ChildIndex = Nodes.AddDefaulted(2);
+			Nodes[ChildIndex].FirstIndex = First;
+			Nodes[ChildIndex].TriangleCount = Half;
+			Nodes[ChildIndex + 1].FirstIndex = First + Half;
+			Nodes[ChildIndex + 1].TriangleCount = Count - Half;
+
+			Nodes[NodeIndex].FirstIndex = ChildIndex;
+			Nodes[NodeIndex].TriangleCount = 0;
+
+			NodesToSplit.Push(ChildIndex);
+			NodesToSplit.Push(ChildIndex + 1);
+		}
 	}
 
 	bool TrackedGeometryCollision::Collides(const FVector Start, const FVector End, const FTransform MeshToWorld,
-		FVector& OutHitPoint, FVector& OutHitNormal, float& OutHitDistance)
+		FVector& OutHitPoint, FVector& OutHitNormal, float& OutHitDistance, ECollisionQuery Query) const
 	{
-		if (MeshToWorld.GetScale3D().IsNearlyZero())
+		if (MeshToWorld.GetScale3D().IsNearlyZero() || Nodes.Num() == 0)
 		{
 			return false;
 		}
@@ -29,27 +211,108 @@ namespace MicrosoftOpenXR
 			return false;
 		}
 
-		// Check for triangle collision and set the output hit position, normal, and distance.
-		for (int i = 0; i < Indices.Num(); i += 3)
+		const TArray<FVector>& Vertices = MeshData->GetVertices();
+		const TArray<MRMESH_INDEX_TYPE>& Indices = MeshData->GetIndices();
+
+		// Hit test in mesh space so the triangles do not need to be transformed.
+		const FVector LocalStart = MeshToWorld.InverseTransformPosition(Start);
+		const FVector LocalDir = MeshToWorld.InverseTransformPosition(End) - LocalStart;
+		const FVector InvDir(1.0f / LocalDir.X, 1.0f / LocalDir.Y, 1.0f / LocalDir.Z);
+
+		struct FStackEntry
+		{
+			int32 NodeIndex;
+			float EntryT;
+		};
+		FStackEntry Stack[MaxTraversalDepth];
+		int32 StackSize = 0;
+
+		float EntryT;
+		if (!SegmentBoxIntersection(LocalStart, InvDir, Nodes[0].Min, Nodes[0].Max, 1.0f, EntryT))
+		{
+			return false;
+		}
+		Stack[StackSize++] = { 0, EntryT };
+
+		// Segment parameter of the closest hit so far, anything further away is skipped.
+		float BestT = 1.0f;
+		int32 HitTriangle = INDEX_NONE;
+
+		while (StackSize > 0)
 		{
-			// Ignore this triangle if it has indices out of range.
-			if ((unsigned int) Indices[i] > (unsigned int) Vertices.Num() ||
-				(unsigned int) Indices[i + 1] > (unsigned int) Vertices.Num() ||
-				(unsigned int) Indices[i + 2] > (unsigned int) Vertices.Num())
+			const FStackEntry Entry = Stack[--StackSize];
+			if (Entry.EntryT > BestT)
+			{
+				// A closer hit was found after this node was visited.
+				continue;
+			}
+
+			const FBVHNode& Node = Nodes[Entry.NodeIndex];
+			if (Node.TriangleCount == 0)
 			{
+				// Visit the child the segment enters first, so later nodes can be culled against its hits.
+				const int32 Left = Node.FirstIndex;
+				const int32 Right = Node.FirstIndex + 1;
+				float LeftT, RightT;
+				const bool bHitLeft = SegmentBoxIntersection(LocalStart, InvDir, Nodes[Left].Min, Nodes[Left].Max, BestT, LeftT);
+				const bool bHitRight = SegmentBoxIntersection(LocalStart, InvDir, Nodes[Right].Min, Nodes[Right].Max, BestT, RightT);
+
+				check(StackSize + 2 <= MaxTraversalDepth);
+				if (bHitLeft && bHitRight)
+				{
+					if (LeftT <= RightT)
+					{
+						Stack[StackSize++] = { Right, RightT };
+						Stack[StackSize++] = { Left, LeftT };
+					}
+					else
+					{
+						Stack[StackSize++] = { Left, LeftT };
+						Stack[StackSize++] = { Right, RightT };
+					}
+				}
+				else if (bHitLeft)
+				{
+					Stack[StackSize++] = { Left, LeftT };
+				}
+				else if (bHitRight)
+				{
+					Stack[StackSize++] = { Right, RightT };
+				}
 				continue;
 			}
 
-			if (FMath::SegmentTriangleIntersection(Start, End, MeshToWorld.TransformPosition(Vertices[Indices[i]]),
-					MeshToWorld.TransformPosition(Vertices[Indices[i + 1]]),
-					MeshToWorld.TransformPosition(Vertices[Indices[i + 2]]), OutHitPoint, OutHitNormal))
+			for (int32 Index = Node.FirstIndex; Index < Node.FirstIndex + Node.TriangleCount; ++Index)
+			{
+				const int32 Triangle = TriangleOrder[Index];
+				float HitT;
+				if (SegmentTriangleIntersection(LocalStart, LocalDir, Vertices[Indices[Triangle * 3]], Vertices[Indices[Triangle * 3 + 1]],
+						Vertices[Indices[Triangle * 3 + 2]], BestT, HitT))
+				{
+					BestT = HitT;
+					HitTriangle = Triangle;
+				}
+			}
+
+			if (HitTriangle != INDEX_NONE && Query == ECollisionQuery::AnyHit)
 			{
-				OutHitDistance = (OutHitPoint - Start).Size();
-				return true;
+				break;
 			}
 		}
 
-		return false;
+		if (HitTriangle == INDEX_NONE)
+		{
+			return false;
+		}
+
+		// Set the output hit position, normal, and distance in world space.
+		const FVector WorldA = MeshToWorld.TransformPosition(Vertices[Indices[HitTriangle * 3]]);
+		const FVector WorldB = MeshToWorld.TransformPosition(Vertices[Indices[HitTriangle * 3 + 1]]);
+		const FVector WorldC = MeshToWorld.TransformPosition(Vertices[Indices[HitTriangle * 3 + 2]]);
+		OutHitNormal = FVector::CrossProduct(WorldB - WorldA, WorldC - WorldA).GetSafeNormal();
+		OutHitPoint = MeshToWorld.TransformPosition(LocalStart + LocalDir * BestT);
+		OutHitDistance = (OutHitPoint - Start).Size();
+		return true;
 	}
 
 	void TrackedGeometryCollision::CreateMeshDataForBoundingBox(FVector Center, FVector HalfExtents, TArray<FVector>& OutVertices, TArray<MRMESH_INDEX_TYPE>& OutIndices)
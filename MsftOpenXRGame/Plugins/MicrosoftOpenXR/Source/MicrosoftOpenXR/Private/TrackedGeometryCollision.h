@@ -6,16 +6,29 @@
 #include "OpenXRCore.h"
 #include "IOpenXRARModule.h"
 #include "IOpenXRARTrackedGeometryHolder.h"
+#include "TrackedMeshData.h"
 
 #include "HeadMountedDisplayTypes.h"
 #include "ARTypes.h"
 
 namespace MicrosoftOpenXR
 {
+	enum class ECollisionQuery : uint8
+	{
+		// Find the hit closest to the start of the ray.
+		ClosestHit,
+		// Stop at the first hit found, for occlusion queries that only need to know if anything was hit.
+		AnyHit
+	};
+
 	class TrackedGeometryCollision
 	{
 	public:
 		TrackedGeometryCollision(TArray<FVector> InVertices, TArray<MRMESH_INDEX_TYPE> InIndices);
+		/// <summary>
+		/// Build collision over mesh data that may also be referenced elsewhere, without copying it.
+		/// </summary>
+		explicit TrackedGeometryCollision(FTrackedMeshDataRef InMeshData);
 
 		/// <summary>
 		/// Hit test a ray against tracked mesh data.
@@ -26,14 +39,46 @@ namespace MicrosoftOpenXR
 		/// <param name="OutHitPoint">Position of hit in world space</param>
 		/// <param name="OutHitNormal">Normal of hit in world space</param>
 		/// <param name="OutHitDistance">Distance from ray start</param>
+		/// <param name="Query">Whether to search for the closest hit or return the first hit found</param>
 		/// <returns>True if the input ray collides with this mesh.</returns>
-		bool Collides(const FVector Start, const FVector End, const FTransform MeshToWorld, FVector& OutHitPoint, FVector& OutHitNormal, float& OutHitDistance);
+		bool Collides(const FVector Start, const FVector End, const FTransform MeshToWorld, FVector& OutHitPoint, FVector& OutHitNormal, float& OutHitDistance,
+			ECollisionQuery Query = ECollisionQuery::ClosestHit) const;
+
+		/// <summary>
+		/// Bounds of the mesh in mesh local space.
+		/// </summary>
+		const FBox& GetBoundingBox() const
+		{
+			return BoundingBox;
+		}
+
+		const FTrackedMeshDataRef& GetMeshData() const
+		{
+			return MeshData;
+		}
 
 		static void CreateMeshDataForBoundingBox(FVector Center, FVector HalfExtents, TArray<FVector>& OutVertices, TArray<MRMESH_INDEX_TYPE>& OutIndices);
 
 	private:
-		TArray<FVector> Vertices;
-		TArray<MRMESH_INDEX_TYPE> Indices;
+		// Node in a bounding volume hierarchy over the mesh triangles in mesh local space.
+		struct FBVHNode
+		{
+			FVector Min;
+			FVector Max;
+			// Interior nodes: index of the first of two consecutive child nodes.
+			// Leaf nodes: index of the first triangle in TriangleOrder.
+			int32 FirstIndex = 0;
+			// Number of triangles in a leaf node, zero for interior nodes.
+			int32 TriangleCount = 0;
+		};
+
+		void BuildBVH();
+
+		FTrackedMeshDataRef MeshData;
+
+		TArray<FBVHNode> Nodes;
+		// Triangle numbers (offset into Indices / 3) grouped by leaf node.
+		TArray<int32> TriangleOrder;
 
 		FBox BoundingBox;
 	};
@@ -0,0 +1,222 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "TrackedGeometrySpatialIndex.h"
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		// Entries spanning more cells than this are tested for every query instead of being added to the grid.
+		constexpr int64 MaxCellsPerEntry = 512;
+	}	 // namespace
+
+	void FTrackedGeometrySpatialIndex::Reset(float InCellSize)
+	{
+		check(InCellSize > 0.0f);
+		CellSize = InCellSize;
+		Entries.Reset();
+		Cells.Reset();
+		OversizedIds.Reset();
+		GridBounds = FBox(ForceInit);
+	}
+
+	FIntVector FTrackedGeometrySpatialIndex::GetCell(const FVector& Position) const
+	{
+		return FIntVector(FMath::FloorToInt(Position.X / CellSize), FMath::FloorToInt(Position.Y / CellSize),
+			FMath::FloorToInt(Position.Z / CellSize));
+	}
+
+	void FTrackedGeometrySpatialIndex::AddToCells(const FGuid& Id, const FEntry& Entry)
+	{
+		if (Entry.bOversized)
+		{
+			OversizedIds.Add(Id);
+			return;
+		}
+
+		for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; ++X)
+		{
+			for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; ++Y)
+			{
+				for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; ++Z)
+				{
+					Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(Id);
+				}
+			}
+		}
+	}
+
+	void FTrackedGeometrySpatialIndex::RemoveFromCells(const FGuid& Id, const FEntry& Entry)
+	{
+		if (Entry.bOversized)
+		{
+			OversizedIds.RemoveSingleSwap(Id, false);
+			return;
+		}
+
+		for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; ++X)
+		{
+			for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; ++Y)
+			{
+				for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; ++Z)
+				{
+					const FIntVector Cell(X, Y, Z);
+					if (TArray<FGuid>* CellIds = Cells.Find(Cell))
+					{
+						CellIds->RemoveSingleSwap(Id, false);
+						if (CellIds->Num() == 0)
+						{
+							Cells.Remove(Cell);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void FTrackedGeometrySpatialIndex::Update(const FGuid& Id, const FBox& Bounds)
+	{
+		if (!Bounds.IsValid)
+		{
+			Remove(Id);
+			return;
+		}
+
+		FEntry NewEntry;
+		NewEntry.Bounds = Bounds;
+		NewEntry.MinCell = GetCell(Bounds.Min);
+		NewEntry.MaxCell = GetCell(Bounds.Max);
+		const int64 CellCount = int64(NewEntry.MaxCell.X - NewEntry.MinCell.X + 1) * int64(NewEntry.MaxCell.Y - NewEntry.MinCell.Y + 1) *
+								int64(NewEntry.MaxCell.Z - NewEntry.MinCell.Z + 1);
+		NewEntry.bOversized = CellCount > MaxCellsPerEntry;
+
+		if (FEntry* Entry = Entries.Find(Id))
+		{
+			// Most updates only move geometry slightly, so the cells are often unchanged.
+			if (Entry->bOversized == NewEntry.bOversized && Entry->MinCell == NewEntry.MinCell && Entry->MaxCell == NewEntry.MaxCell)
+			{
+				Entry->Bounds = Bounds;
+				GridBounds += Bounds;
+				return;
+			}
+
+			RemoveFromCells(Id, *Entry);
+			*Entry = NewEntry;
+		}
+		else
+		{
+			Entries.Add(Id, NewEntry);
+		}
+
+		AddToCells(Id, NewEntry);
+		GridBounds += Bounds;
+	}
+
+	void FTrackedGeometrySpatialIndex::Remove(const FGuid& Id)
+	{
+		FEntry Entry;
+		if (Entries.RemoveAndCopyValue(Id, Entry))
+		{
+			RemoveFromCells(Id, Entry);
+		}
+	}
+
+	void FTrackedGeometrySpatialIndex::QuerySegment(const FVector& Start, const FVector& End, TArray<FGuid>& OutIds) const
+	{
+		const FVector Dir = End - Start;
+		auto AddIfHit = [this, &Start, &End, &Dir, &OutIds](const FGuid& Id) {
+			if (!OutIds.Contains(Id) && FMath::LineBoxIntersection(Entries.FindChecked(Id).Bounds, Start, End, Dir))
+			{
+				OutIds.Add(Id);
+			}
+		};
+
+		for (const FGuid& Id : OversizedIds)
+		{
+			AddIfHit(Id);
+		}
+
+		if (Cells.Num() == 0)
+		{
+			return;
+		}
+
+		// Clip the segment to the populated part of the grid so long traces do not walk empty cells.
+		float TStart = 0.0f;
+		float TEnd = 1.0f;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (FMath::IsNearlyZero(Dir[Axis]))
+			{
+				if (Start[Axis] < GridBounds.Min[Axis] || Start[Axis] > GridBounds.Max[Axis])
+				{
+					return;
+				}
+				continue;
+			}
+
+			float T0 = (GridBounds.Min[Axis] - Start[Axis]) / Dir[Axis];
+			float T1 = (GridBounds.Max[Axis] - Start[Axis]) / Dir[Axis];
+			if (T0 > T1)
+			{
+				Swap(T0, T1);
+			}
+			TStart = FMath::Max(TStart, T0);
+			TEnd = FMath::Min(TEnd, T1);
+			if (TStart > TEnd)
+			{
+				return;
+			}
+		}
+
+		// Walk the cells the segment passes through (Amanatides and Woo).
+		FIntVector Cell = GetCell(Start + Dir * TStart);
+		const FIntVector EndCell = GetCell(Start + Dir * TEnd);
+
+		FIntVector Step;
+		FVector TNext;
+		FVector TDelta;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (FMath::IsNearlyZero(Dir[Axis]))
+			{
+				Step[Axis] = 0;
+				TNext[Axis] = BIG_NUMBER;
+				TDelta[Axis] = BIG_NUMBER;
+				continue;
+			}
+
+			Step[Axis] = Dir[Axis] > 0.0f ? 1 : -1;
+			const float Boundary = (Cell[Axis] + (Step[Axis] > 0 ? 1 : 0)) * CellSize;
+			TNext[Axis] = (Boundary - Start[Axis]) / Dir[Axis];
+			TDelta[Axis] = CellSize / FMath::Abs(Dir[Axis]);
+		}
+
+		// The walk can not visit more cells than this, guards against float error at cell boundaries.
+		const int32 MaxSteps = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y) + FMath::Abs(EndCell.Z - Cell.Z) + 1;
+		for (int32 StepIndex = 0; StepIndex < MaxSteps; ++StepIndex)
+		{
+			if (const TArray<FGuid>* CellIds = Cells.Find(Cell))
+			{
+				for (const FGuid& Id : *CellIds)
+				{
+					AddIfHit(Id);
+				}
+			}
+
+			if (Cell == EndCell)
+			{
+				break;
+			}
+
+			const int32 Axis = TNext.X < TNext.Y ? (TNext.X < TNext.Z ? 0 : 2) : (TNext.Y < TNext.Z ? 1 : 2);
+			if (TNext[Axis] > TEnd)
+			{
+				break;
+			}
+			Cell[Axis] += Step[Axis];
+			TNext[Axis] += TDelta[Axis];
+		}
+	}
+}	 // namespace MicrosoftOpenXR
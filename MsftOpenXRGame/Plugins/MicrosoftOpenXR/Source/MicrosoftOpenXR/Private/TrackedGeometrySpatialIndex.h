@@ -0,0 +1,65 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Uniform grid over the bounds of tracked geometry, used to find the geometry a line trace can hit
+	/// without testing every mesh in the scene.  Entries are added, moved and removed incrementally.
+	/// Bounds and queries must use the same space, for example tracking space.
+	/// </summary>
+	class FTrackedGeometrySpatialIndex
+	{
+	public:
+		/// <summary>
+		/// Remove all entries and set the size of a grid cell.
+		/// </summary>
+		void Reset(float InCellSize);
+
+		/// <summary>
+		/// Add an entry, or move an existing entry to new bounds.
+		/// </summary>
+		void Update(const FGuid& Id, const FBox& Bounds);
+
+		void Remove(const FGuid& Id);
+
+		/// <summary>
+		/// Find every entry whose bounds intersect a line segment.
+		/// </summary>
+		/// <param name="Start">Start of the segment</param>
+		/// <param name="End">End of the segment</param>
+		/// <param name="OutIds">Ids of the intersected entries, each id is added once</param>
+		void QuerySegment(const FVector& Start, const FVector& End, TArray<FGuid>& OutIds) const;
+
+		int32 Num() const
+		{
+			return Entries.Num();
+		}
+
+	private:
+		struct FEntry
+		{
+			FBox Bounds;
+			FIntVector MinCell;
+			FIntVector MaxCell;
+			// Entries covering too many cells are kept in OversizedIds instead of the grid.
+			bool bOversized = false;
+		};
+
+		FIntVector GetCell(const FVector& Position) const;
+		void AddToCells(const FGuid& Id, const FEntry& Entry);
+		void RemoveFromCells(const FGuid& Id, const FEntry& Entry);
+
+		float CellSize = 200.0f;
+		TMap<FGuid, FEntry> Entries;
+		TMap<FIntVector, TArray<FGuid>> Cells;
+		TArray<FGuid> OversizedIds;
+
+		// Union of every entry added since the last reset, used to clip queries to the populated part of the grid.
+		FBox GridBounds{ForceInit};
+	};
+}	 // namespace MicrosoftOpenXR
@@ -0,0 +1,169 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "TrackedGeometryTrace.h"
+
+#include "ARTrackable.h"
+#include "Async/ParallelFor.h"
+
+namespace MicrosoftOpenXR
+{
+	namespace
+	{
+		// Plane hits report the plane extent channel they were traced with, mesh hits the other requested channels.
+		EARLineTraceChannels GetHitTraceChannels(EARLineTraceChannels TraceChannels, bool bPlane)
+		{
+			return bPlane ? EARLineTraceChannels::PlaneUsingExtent
+						  : (EARLineTraceChannels)((int32)TraceChannels & ~(int32)EARLineTraceChannels::PlaneUsingExtent);
+		}
+	}	 // namespace
+
+	TArray<FARTraceResult> LineTraceTrackedGeometry(const FTrackedGeometryTraceScene& Scene, FFindTraceGeometry FindGeometry,
+		const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe>& ARCompositionComponent, const FVector& Start, const FVector& End,
+		EARLineTraceChannels TraceChannels)
+	{
+		// Always hittest meshes, but only hittest planes if PlaneUsingExtent is enabled.
+		// This is because some planes may be floating in space, like wall planes through an open door.
+		const bool bHitTestPlanes = ((int32)TraceChannels & (int32)EARLineTraceChannels::PlaneUsingExtent) != 0;
+
+		const FVector TrackingStart = Scene.TrackingToWorld.InverseTransformPosition(Start);
+		const FVector TrackingEnd = Scene.TrackingToWorld.InverseTransformPosition(End);
+
+		TArray<FARTraceResult> Results;
+		TArray<FGuid> Candidates;
+		auto TraceCandidates = [&](const TMap<FGuid, TrackedGeometryCollision>& CollisionInfos, bool bPlanes) {
+			const EARLineTraceChannels HitTraceChannels = GetHitTraceChannels(TraceChannels, bPlanes);
+			for (const FGuid& Id : Candidates)
+			{
+				const TrackedGeometryCollision* CollisionInfo = CollisionInfos.Find(Id);
+				FTransform LocalToWorld;
+				UARTrackedGeometry* Geometry = CollisionInfo != nullptr ? FindGeometry(Id, LocalToWorld) : nullptr;
+				FVector HitPoint, HitNormal;
+				float HitDistance;
+				if (Geometry != nullptr && CollisionInfo->Collides(Start, End, LocalToWorld, HitPoint, HitNormal, HitDistance))
+				{
+					// Append a hit.  The calling function will then sort by HitDistance.
+					Results.Add(FARTraceResult(
+						ARCompositionComponent, HitDistance, HitTraceChannels, FTransform(HitNormal.ToOrientationQuat(), HitPoint), Geometry));
+				}
+			}
+		};
+
+		Scene.MeshSpatialIndex.QuerySegment(TrackingStart, TrackingEnd, Candidates);
+		TraceCandidates(Scene.MeshCollisionInfo, false);
+
+		if (bHitTestPlanes)
+		{
+			Candidates.Reset();
+			Scene.PlaneSpatialIndex.QuerySegment(TrackingStart, TrackingEnd, Candidates);
+			TraceCandidates(Scene.PlaneCollisionInfo, true);
+		}
+		return Results;
+	}
+
+	void LineTraceTrackedGeometry(const FTrackedGeometryTraceScene& Scene, FFindTraceGeometry FindGeometry,
+		const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe>& ARCompositionComponent,
+		TArrayView<const FTrackedGeometryTraceSegment> Segments, bool bTracePlanes, bool bMultithreaded,
+		TArrayView<FTrackedGeometryTraceResult> InOutResults)
+	{
+		check(Segments.Num() == InOutResults.Num());
+
+		if (Scene.MeshSpatialIndex.Num() == 0 && (!bTracePlanes || Scene.PlaneSpatialIndex.Num() == 0))
+		{
+			return;
+		}
+
+		const int32 NumSegments = Segments.Num();
+
+		// The spatial indices are only read while gathering candidates, so every segment can query them at once.
+		TArray<TArray<FGuid>> Candidates;
+		Candidates.SetNum(NumSegments);
+		ParallelFor(
+			NumSegments,
+			[&](int32 Index) {
+				const FVector TrackingStart = Scene.TrackingToWorld.InverseTransformPosition(Segments[Index].Start);
+				const FVector TrackingEnd = Scene.TrackingToWorld.InverseTransformPosition(Segments[Index].End);
+				Scene.MeshSpatialIndex.QuerySegment(TrackingStart, TrackingEnd, Candidates[Index]);
+				if (bTracePlanes)
+				{
+					Scene.PlaneSpatialIndex.QuerySegment(TrackingStart, TrackingEnd, Candidates[Index]);
+				}
+			},
+			!bMultithreaded);
+
+		// Resolve each candidate's geometry once on the calling thread, so the traces only read plain data.
+		struct FTraceTarget
+		{
+			const TrackedGeometryCollision* CollisionInfo;
+			FTransform LocalToWorld;
+			UARTrackedGeometry* Geometry;
+			// The channels of a hit, which depend on whether the target is a plane or a mesh.
+			EARLineTraceChannels TraceChannels;
+		};
+		const EARLineTraceChannels RequestedTraceChannels = bTracePlanes ? EARLineTraceChannels::PlaneUsingExtent : EARLineTraceChannels::None;
+		TMap<FGuid, FTraceTarget> Targets;
+		for (const TArray<FGuid>& SegmentCandidates : Candidates)
+		{
+			for (const FGuid& Id : SegmentCandidates)
+			{
+				if (Targets.Contains(Id))
+				{
+					continue;
+				}
+
+				const TrackedGeometryCollision* CollisionInfo = Scene.MeshCollisionInfo.Find(Id);
+				const bool bPlane = CollisionInfo == nullptr;
+				if (bPlane)
+				{
+					CollisionInfo = Scene.PlaneCollisionInfo.Find(Id);
+				}
+				FTransform LocalToWorld;
+				UARTrackedGeometry* Geometry = CollisionInfo != nullptr ? FindGeometry(Id, LocalToWorld) : nullptr;
+				if (Geometry != nullptr)
+				{
+					Targets.Add(Id, FTraceTarget{CollisionInfo, LocalToWorld, Geometry, GetHitTraceChannels(RequestedTraceChannels, bPlane)});
+				}
+			}
+		}
+
+		if (Targets.Num() == 0)
+		{
+			return;
+		}
+
+		ParallelFor(
+			NumSegments,
+			[&](int32 Index) {
+				const FVector& Start = Segments[Index].Start;
+				const FVector& End = Segments[Index].End;
+				FTrackedGeometryTraceResult& Result = InOutResults[Index];
+
+				const FTraceTarget* BestTarget = nullptr;
+				float BestDistance = Result.bHit ? Result.Hit.GetDistanceFromCamera() : MAX_flt;
+				FVector BestPoint, BestNormal;
+				for (const FGuid& Id : Candidates[Index])
+				{
+					const FTraceTarget* Target = Targets.Find(Id);
+					FVector HitPoint, HitNormal;
+					float HitDistance;
+					if (Target != nullptr &&
+						Target->CollisionInfo->Collides(Start, End, Target->LocalToWorld, HitPoint, HitNormal, HitDistance) &&
+						HitDistance < BestDistance)
+					{
+						BestTarget = Target;
+						BestDistance = HitDistance;
+						BestPoint = HitPoint;
+						BestNormal = HitNormal;
+					}
+				}
+
+				if (BestTarget != nullptr)
+				{
+					Result.bHit = true;
+					Result.Hit = FARTraceResult(ARCompositionComponent, BestDistance, BestTarget->TraceChannels,
+						FTransform(BestNormal.ToOrientationQuat(), BestPoint), BestTarget->Geometry);
+				}
+			},
+			!bMultithreaded);
+	}
+}	 // namespace MicrosoftOpenXR
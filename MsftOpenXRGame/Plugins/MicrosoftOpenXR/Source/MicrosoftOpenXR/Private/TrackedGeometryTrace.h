@@ -0,0 +1,49 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ARTypes.h"
+#include "MicrosoftOpenXR.h"
+#include "TrackedGeometryCollision.h"
+#include "TrackedGeometrySpatialIndex.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Collision data of the tracked meshes and planes, with their bounds in spatial indices in tracking space.
+	/// </summary>
+	struct FTrackedGeometryTraceScene
+	{
+		const TMap<FGuid, TrackedGeometryCollision>& MeshCollisionInfo;
+		const TMap<FGuid, TrackedGeometryCollision>& PlaneCollisionInfo;
+		const FTrackedGeometrySpatialIndex& MeshSpatialIndex;
+		const FTrackedGeometrySpatialIndex& PlaneSpatialIndex;
+		FTransform TrackingToWorld;
+	};
+
+	/// <summary>
+	/// Finds the tracked geometry of a mesh or plane id and its local to world transform.
+	/// Returns nullptr if the geometry has not been created yet.  Only called on the calling thread.
+	/// </summary>
+	using FFindTraceGeometry = TFunctionRef<class UARTrackedGeometry*(const FGuid& Id, FTransform& OutLocalToWorld)>;
+
+	/// <summary>
+	/// Trace a world space segment against the scene, returning every hit.
+	/// Plane hits report PlaneUsingExtent, mesh hits the requested channels without it.
+	/// </summary>
+	TArray<FARTraceResult> LineTraceTrackedGeometry(const FTrackedGeometryTraceScene& Scene, FFindTraceGeometry FindGeometry,
+		const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe>& ARCompositionComponent, const FVector& Start, const FVector& End,
+		EARLineTraceChannels TraceChannels);
+
+	/// <summary>
+	/// Trace a batch of world space segments against the scene, keeping the closest hit per segment.
+	/// A result is only replaced by a closer hit.  Hits report the channels a single trace with PlaneUsingExtent set
+	/// when tracing planes would.
+	/// </summary>
+	void LineTraceTrackedGeometry(const FTrackedGeometryTraceScene& Scene, FFindTraceGeometry FindGeometry,
+		const TSharedPtr<FARSupportInterface, ESPMode::ThreadSafe>& ARCompositionComponent,
+		TArrayView<const FTrackedGeometryTraceSegment> Segments, bool bTracePlanes, bool bMultithreaded,
+		TArrayView<FTrackedGeometryTraceResult> InOutResults);
+}	 // namespace MicrosoftOpenXR
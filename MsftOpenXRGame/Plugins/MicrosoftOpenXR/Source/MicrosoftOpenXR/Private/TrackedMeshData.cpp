@@ -0,0 +1,33 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "TrackedMeshData.h"
+
+namespace MicrosoftOpenXR
+{
+	struct FTrackedMeshDataDeleter
+	{
+		TSharedPtr<FMeshBufferPool, ESPMode::ThreadSafe> Pool;
+
+		void operator()(FTrackedMeshData* MeshData) const
+		{
+			if (Pool.IsValid())
+			{
+				Pool->Vertices.Release(MeshData->Vertices);
+				Pool->Indices.Release(MeshData->Indices);
+			}
+			delete MeshData;
+		}
+	};
+
+	FTrackedMeshDataRef MakeTrackedMeshData(TArray<FVector>&& Vertices, TArray<MRMESH_INDEX_TYPE>&& Indices,
+		const TSharedPtr<FMeshBufferPool, ESPMode::ThreadSafe>& Pool)
+	{
+		if (!Pool.IsValid())
+		{
+			return MakeShared<FTrackedMeshData, ESPMode::ThreadSafe>(MoveTemp(Vertices), MoveTemp(Indices));
+		}
+
+		return FTrackedMeshDataRef(new FTrackedMeshData(MoveTemp(Vertices), MoveTemp(Indices)), FTrackedMeshDataDeleter{Pool});
+	}
+}	 // namespace MicrosoftOpenXR
@@ -0,0 +1,52 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IOpenXRARTrackedGeometryHolder.h"
+#include "MeshBufferPool.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Mesh buffers that are never modified once created, so collision, scene bookkeeping and mesh submission
+	/// can all reference one copy from any thread.
+	/// </summary>
+	class FTrackedMeshData
+	{
+	public:
+		FTrackedMeshData(TArray<FVector>&& InVertices, TArray<MRMESH_INDEX_TYPE>&& InIndices)
+			: Vertices(MoveTemp(InVertices)), Indices(MoveTemp(InIndices))
+		{
+		}
+
+		const TArray<FVector>& GetVertices() const
+		{
+			return Vertices;
+		}
+
+		const TArray<MRMESH_INDEX_TYPE>& GetIndices() const
+		{
+			return Indices;
+		}
+
+	private:
+		friend struct FTrackedMeshDataDeleter;
+
+		TArray<FVector> Vertices;
+		TArray<MRMESH_INDEX_TYPE> Indices;
+	};
+
+	using FTrackedMeshDataRef = TSharedRef<const FTrackedMeshData, ESPMode::ThreadSafe>;
+	using FTrackedMeshDataPtr = TSharedPtr<const FTrackedMeshData, ESPMode::ThreadSafe>;
+
+	/// <summary>
+	/// Wrap mesh buffers in shared mesh data.
+	/// </summary>
+	/// <param name="Vertices">Vertex buffer, moved into the mesh data</param>
+	/// <param name="Indices">Index buffer, moved into the mesh data</param>
+	/// <param name="Pool">Optional pool the buffers are returned to when the last reference is released</param>
+	FTrackedMeshDataRef MakeTrackedMeshData(TArray<FVector>&& Vertices, TArray<MRMESH_INDEX_TYPE>&& Indices,
+		const TSharedPtr<FMeshBufferPool, ESPMode::ThreadSafe>& Pool = nullptr);
+}	 // namespace MicrosoftOpenXR
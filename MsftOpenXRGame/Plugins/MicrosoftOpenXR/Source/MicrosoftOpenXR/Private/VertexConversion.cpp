@@ -0,0 +1,80 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "VertexConversion.h"
+
+#include "CoreMinimal.h"
+#include "Math/VectorRegister.h"
+
+namespace MicrosoftOpenXR
+{
+	static_assert(sizeof(XrVector3f) == sizeof(FVector), "OpenXR and Unreal vectors must have the same layout.");
+
+	FORCEINLINE void ConvertXrVectorToFVector(const XrVector3f& In, FVector& Out, float Scale)
+	{
+		// Copy first so this is safe when converting in place.
+		const XrVector3f Vector = In;
+		Out = FVector(-Vector.z * Scale, Vector.x * Scale, Vector.y * Scale);
+	}
+
+	void ConvertXrVectorsToFVectors(const XrVector3f* In, FVector* Out, int32 Count, float Scale)
+	{
+		const float* Src = reinterpret_cast<const float*>(In);
+		float* Dest = reinterpret_cast<float*>(Out);
+
+		// Unreal (X, Y, Z) = OpenXR (-Z, X, Y) * Scale.
+		// Four packed vectors span three registers, so the sign of each lane depends on which register it lands in:
+		//   A = [x0 y0 z0 x1]  ->  [-z0  x0  y0 -z1]
+		//   B = [y1 z1 x2 y2]  ->  [ x1  y1 -z2  x2]
+		//   C = [z2 x3 y3 z3]  ->  [ y2 -z3  x3  y3]
+		const VectorRegister ScaleA = MakeVectorRegister(-Scale, Scale, Scale, -Scale);
+		const VectorRegister ScaleB = MakeVectorRegister(Scale, Scale, -Scale, Scale);
+		const VectorRegister ScaleC = MakeVectorRegister(Scale, -Scale, Scale, Scale);
+
+		const int32 BlockCount = Count / 4;
+		for (int32 Block = 0; Block < BlockCount; ++Block)
+		{
+			const VectorRegister A = VectorLoad(Src);
+			const VectorRegister B = VectorLoad(Src + 4);
+			const VectorRegister C = VectorLoad(Src + 8);
+
+			// [x0 y0 z1 z1] -> [z0 x0 y0 z1]
+			const VectorRegister A0 = VectorShuffle(A, B, 0, 1, 1, 1);
+			const VectorRegister OutA = VectorShuffle(A, A0, 2, 0, 1, 2);
+
+			// [x1 x1 y1 y1] and [z2 z2 x2 x2] -> [x1 y1 z2 x2]
+			const VectorRegister B0 = VectorShuffle(A, B, 3, 3, 0, 0);
+			const VectorRegister B1 = VectorShuffle(C, B, 0, 0, 2, 2);
+			const VectorRegister OutB = VectorShuffle(B0, B1, 0, 2, 0, 2);
+
+			// [y2 y2 z3 z3] -> [y2 z3 x3 y3]
+			const VectorRegister C0 = VectorShuffle(B, C, 3, 3, 3, 3);
+			const VectorRegister OutC = VectorShuffle(C0, C, 0, 2, 1, 2);
+
+			VectorStore(VectorMultiply(OutA, ScaleA), Dest);
+			VectorStore(VectorMultiply(OutB, ScaleB), Dest + 4);
+			VectorStore(VectorMultiply(OutC, ScaleC), Dest + 8);
+
+			Src += 12;
+			Dest += 12;
+		}
+
+		for (int32 Index = BlockCount * 4; Index < Count; ++Index)
+		{
+			ConvertXrVectorToFVector(In[Index], Out[Index], Scale);
+		}
+	}
+
+	void ConvertXrVectorsToFVectors(const XrVector3f* In, int32 InStride, FVector* Out, int32 Count, float Scale)
+	{
+		const uint8* Src = reinterpret_cast<const uint8*>(In);
+		const VectorRegister ScaleVector = MakeVectorRegister(-Scale, Scale, Scale, 0.0f);
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const VectorRegister Vector = VectorLoadFloat3(Src);
+			VectorStoreFloat3(VectorMultiply(VectorSwizzle(Vector, 2, 0, 1, 3), ScaleVector), &Out[Index]);
+			Src += InStride;
+		}
+	}
+}	 // namespace MicrosoftOpenXR
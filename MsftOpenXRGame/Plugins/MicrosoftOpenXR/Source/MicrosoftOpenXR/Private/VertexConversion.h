@@ -0,0 +1,29 @@
+// Copyright (c) 2022 Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "OpenXRCommon.h"
+
+namespace MicrosoftOpenXR
+{
+	/// <summary>
+	/// Converts tightly packed OpenXR vectors to Unreal's coordinate system, the same as ToFVector(Vector, Scale) per element.
+	/// Four vectors are converted at a time with SIMD.  In and Out may point to the same memory to convert in place.
+	/// </summary>
+	/// <param name="In">Source vectors in OpenXR coordinates</param>
+	/// <param name="Out">Destination vectors in Unreal coordinates</param>
+	/// <param name="Count">Number of vectors to convert</param>
+	/// <param name="Scale">Scale applied to every vector, usually WorldToMetersScale</param>
+	void ConvertXrVectorsToFVectors(const XrVector3f* In, FVector* Out, int32 Count, float Scale);
+
+	/// <summary>
+	/// Converts OpenXR vectors that are interleaved with other data, like the positions in XrHandMeshVertexMSFT.
+	/// </summary>
+	/// <param name="In">First source vector in OpenXR coordinates</param>
+	/// <param name="InStride">Distance in bytes between consecutive source vectors</param>
+	/// <param name="Out">Tightly packed destination vectors in Unreal coordinates, must not overlap the source</param>
+	/// <param name="Count">Number of vectors to convert</param>
+	/// <param name="Scale">Scale applied to every vector, usually WorldToMetersScale</param>
+	void ConvertXrVectorsToFVectors(const XrVector3f* In, int32 InStride, FVector* Out, int32 Count, float Scale);
+}	 // namespace MicrosoftOpenXR
@@ -7,6 +7,8 @@
 #include "UObject/ObjectMacros.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Components/InputComponent.h"
+#include "ARTraceResult.h"
+#include "PackedNormal.h"
 
 #include "AzureObjectAnchorTypes.h"
 
@@ -15,6 +17,27 @@
 // Currently remoting only supports x64 Windows: Editor and Packaged Exe
 #define SUPPORTS_REMOTING (PLATFORM_WINDOWS && PLATFORM_64BITS)
 
+class FRHICommandListImmediate;
+class FRHIVertexBuffer;
+
+// Hand mesh in the compact layout renderers upload, filled by UMicrosoftOpenXRFunctionLibrary::GetPackedHandMeshData.
+// Keep one per hand across frames so its buffers are reused.
+struct FPackedHandMeshData
+{
+	// Local to world transform of the hand mesh.
+	FTransform HandMeshTransform;
+	// Vertex positions in hand mesh space.
+	TArray<FVector> Positions;
+	// Normals as signed 8 bit vectors, the format of TangentZ in the engine's static mesh vertex buffers.
+	TArray<FPackedNormal> Normals;
+	// Double sided triangle list.
+	TArray<uint16> Indices;
+	// Key of the runtime index buffer in Indices, Indices are only rewritten when it changes.
+	uint32 IndexBufferKey = 0;
+	// True when the last call rewrote Indices.
+	bool bIndicesChanged = false;
+};
+
 USTRUCT(BlueprintType, Category = "MicrosoftOpenXR|OpenXR")
 struct FKeywordInput
 {
@@ -27,6 +50,31 @@ struct FKeywordInput
 	FInputActionHandlerDynamicSignature Callback;
 };
 
+USTRUCT(BlueprintType, Category = "MicrosoftOpenXR|OpenXR")
+struct FTrackedGeometryTraceSegment
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MicrosoftOpenXR|OpenXR")
+	FVector Start = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MicrosoftOpenXR|OpenXR")
+	FVector End = FVector::ZeroVector;
+};
+
+USTRUCT(BlueprintType, Category = "MicrosoftOpenXR|OpenXR")
+struct FTrackedGeometryTraceResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "MicrosoftOpenXR|OpenXR")
+	bool bHit = false;
+
+	// Closest hit along the segment, only valid if bHit is true.
+	UPROPERTY(BlueprintReadOnly, Category = "MicrosoftOpenXR|OpenXR")
+	FARTraceResult Hit;
+};
+
 UENUM(BlueprintType, Category = "MicrosoftOpenXR|OpenXR")
 enum class EHandMeshStatus : uint8
 {
@@ -36,6 +84,19 @@ enum class EHandMeshStatus : uint8
 	EnabledXRVisualization = 3
 };
 
+UENUM(BlueprintType, Category = "MicrosoftOpenXR|OpenXR")
+enum class ESceneScanMode : uint8
+{
+	// Start the next scan as soon as the observer is free.
+	Continuous,
+	// Start a scan at a fixed interval.
+	Interval,
+	// Start a scan once the head has moved far enough from where the previous scan started.
+	HeadMovement,
+	// Only start a scan when one is requested.
+	OnDemand
+};
+
 UCLASS(ClassGroup = OpenXR)
 class MICROSOFTOPENXR_API UMicrosoftOpenXRFunctionLibrary :
 	public UBlueprintFunctionLibrary
@@ -53,6 +114,17 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
 	static bool SetUseHandMesh(EHandMeshStatus Mode);
 
+	// Render thread only. When xr.MicrosoftOpenXR.HandMesh.LateLatching is set and the hand mesh is used for XR visualization,
+	// copies the latest hand mesh vertices read just before a frame is submitted into a dynamic vertex buffer of FVector positions in tracking space.
+	// These are read for this frame only if it has already begun on the RHI thread, otherwise they are the previous frame's.
+	static void UpdateLateLatchedHandMeshVertexBuffer_RenderThread(FRHICommandListImmediate& RHICmdList, EControllerHand Hand, FRHIVertexBuffer* VertexBuffer);
+
+	// Game thread only. A packed alternative to IHandTracker::GetHandMeshData when the hand mesh is used for XR visualization,
+	// that reuses the caller's buffers and only copies the indices when the hand topology changes. The normals are packed by each call.
+	// The MicrosoftOpenXR.HandMesh.PackedCopyPerformance automation test compares the two paths on a synthetic hand mesh,
+	// and on device the "Get Hand Mesh Data" and "Get Packed Hand Mesh Data" cycle stats of `stat MicrosoftOpenXR` show their cost.
+	static bool GetPackedHandMeshData(EControllerHand Hand, FPackedHandMeshData& InOutMesh);
+
 	/**
 	Is QR Tracking enabled
 
@@ -113,6 +185,68 @@ public:
 	UFUNCTION(BlueprintPure, Category = "MicrosoftOpenXR|OpenXR")
 	static bool CanDetectPlanes();
 
+	/**
+	Trace many segments against the planes and meshes from spatial mapping and scene understanding at once.
+	Geometry lookups are shared by the whole batch, which is much cheaper than tracing each segment on its own.
+
+	@param Segments World space segments to trace.
+	@param bTestPlaneExtents If true, also trace against scene understanding planes.
+	@param bMultithreaded If true, spread the segments over worker threads.
+	@return One result per segment, with the closest hit along that segment.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static TArray<FTrackedGeometryTraceResult> LineTraceTrackedObjectsBatched(
+		const TArray<FTrackedGeometryTraceSegment>& Segments, bool bTestPlaneExtents = true, bool bMultithreaded = true);
+
+	/**
+	Set when spatial mapping and scene understanding scan the environment.
+	Scanning continuously keeps the geometry up to date, at a significant power and thermal cost.
+
+	@param Mode When to start a new scan.
+	@param IntervalSeconds Time between the starts of scans in Interval mode.
+	@param MovementThreshold Distance the head moves between scans in HeadMovement mode.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static void SetSceneScanMode(ESceneScanMode Mode, float IntervalSeconds = 5.0f, float MovementThreshold = 100.0f);
+
+	/** Start a new spatial mapping and scene understanding scan as soon as possible, in any scan mode. */
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static void RequestSceneScan();
+
+	/**
+	Limit spatial mapping and scene understanding scans to a sphere in world space, along with any other bounds added.
+	Smaller volumes scan faster and produce smaller scenes. Geometry outside every volume is removed by the next scan.
+
+	@param Center Center of the sphere.
+	@param Radius Radius of the sphere.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static void AddSceneScanSphereBound(FVector Center, float Radius);
+
+	/**
+	Limit spatial mapping and scene understanding scans to an oriented box in world space, along with any other bounds added.
+
+	@param Transform Position and orientation of the center of the box.
+	@param Extent Half the size of the box along each of its axes.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static void AddSceneScanBoxBound(FTransform Transform, FVector Extent);
+
+	/**
+	Limit spatial mapping and scene understanding scans to a frustum in world space, along with any other bounds added.
+
+	@param Transform Position of the apex of the frustum, looking along the forward axis.
+	@param HorizontalFOV Full horizontal angle of the frustum in degrees.
+	@param VerticalFOV Full vertical angle of the frustum in degrees.
+	@param FarDistance Distance from the apex to the far plane.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static void AddSceneScanFrustumBound(FTransform Transform, float HorizontalFOV, float VerticalFOV, float FarDistance);
+
+	/** Remove every bound added, so scans cover the default volume around the head again. */
+	UFUNCTION(BlueprintCallable, Category = "MicrosoftOpenXR|OpenXR")
+	static void ClearSceneScanBounds();
+
 	// Azure Object Anchors
 	/*Toggle Azure Object Anchor detection on or off.
 	@note After toggling on, InitAzureObjectAnchors must be called with a valid session configuration.